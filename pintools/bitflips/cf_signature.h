@@ -0,0 +1,301 @@
+#ifndef CF_SIGNATURE_MATI_H
+#define CF_SIGNATURE_MATI_H
+
+// Firma de flujo de control de la region medida, para marcar faults que
+// cambian el camino dentro de OpenFHE (una reduccion extra, un throw).
+//
+// Por region (una iteracion entre sync_marker) se acumula:
+//   - hash rodante FNV-1a de la secuencia de BBLs ejecutados. Las direcciones
+//     son offsets dentro de su imagen, asi no dependen de ASLR
+//   - cantidad de BBLs por rutina
+//   - el hash cada `interval` BBLs (checkpoints), para comparar en vivo
+// En modo record las firmas van al archivo golden. En modo compare cada BBL
+// que cae en un checkpoint se compara con el golden; la primera diferencia
+// marca la region como divergente y, con stop, termina la aplicacion.
+//
+// Si el golden tiene menos regiones que la corrida se reusa la ultima: las
+// iteraciones de una campaña hacen el mismo trabajo.
+//
+// Header-only y sin excepciones, para incluir en cualquier pintool de bitflips.
+
+#include "pin.H"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace cfsig {
+
+static const UINT64 FNV_OFFSET = 0xcbf29ce484222325ULL;
+static const UINT64 FNV_PRIME  = 0x100000001b3ULL;
+static const int EXIT_DIVERGENT = 3;
+
+struct Signature {
+    UINT64 hash = FNV_OFFSET;
+    UINT64 bbls = 0;
+    std::vector<UINT64> checkpoints;
+    std::map<std::string, UINT64> rtnBbls;    // solo en golden y al cerrar la region
+};
+
+struct State {
+    bool enabled = false;
+    bool record = false;
+    bool stopOnDivergence = false;
+    UINT64 interval = 4096;
+    std::string func;                          // vacio: toda la region cuenta
+    std::string goldenFile;
+    std::ofstream log;
+
+    ADDRINT depth = 0;
+    THREADID owner = 0;                        // hilo que abrio la region (no cuenta hilos de logging)
+    Signature cur;
+    std::vector<UINT64> rtnCount;              // indexado por id de rutina
+    std::vector<std::string> rtnNames;
+    std::map<std::string, UINT32> rtnIds;
+
+    std::vector<Signature> golden;
+    std::vector<Signature> recorded;
+    const Signature* expected = nullptr;
+    bool diverged = false;
+    UINT64 divergedAt = 0;                     // BBL del primer checkpoint distinto
+    UINT64 regions = 0;
+    std::string tag;                           // fault de la region actual, para el log
+    UINT64 divergentRegions = 0;
+};
+
+static State st;
+
+inline UINT32 RoutineId(const std::string& name) {
+    std::map<std::string, UINT32>::iterator it = st.rtnIds.find(name);
+    if (it != st.rtnIds.end())
+        return it->second;
+    UINT32 id = st.rtnNames.size();
+    st.rtnIds[name] = id;
+    st.rtnNames.push_back(name);
+    st.rtnCount.push_back(0);
+    return id;
+}
+
+// Formato: "R <hash> <bbls>", "C <hash>..." y "F <rutina> <bbls>" por rutina
+inline bool LoadGolden(const std::string& file) {
+    std::ifstream in(file.c_str());
+    if (!in) {
+        std::cerr << "[ERROR] No pude abrir golden de flujo: " << file << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string tag;
+        iss >> tag;
+        if (tag == "R") {
+            st.golden.push_back(Signature());
+            iss >> std::hex >> st.golden.back().hash >> std::dec >> st.golden.back().bbls;
+        }
+        else if (tag == "C" && !st.golden.empty()) {
+            UINT64 h;
+            while (iss >> std::hex >> h)
+                st.golden.back().checkpoints.push_back(h);
+        }
+        else if (tag == "F" && !st.golden.empty()) {
+            std::string name;
+            UINT64 count;
+            iss >> name >> count;
+            st.golden.back().rtnBbls[name] = count;
+        }
+    }
+    return !st.golden.empty();
+}
+
+inline void SaveGolden() {
+    std::ofstream out(st.goldenFile.c_str());
+    if (!out) {
+        std::cerr << "[ERROR] No pude escribir golden de flujo: " << st.goldenFile << std::endl;
+        return;
+    }
+    for (size_t r = 0; r < st.recorded.size(); ++r) {
+        const Signature& s = st.recorded[r];
+        out << "R " << std::hex << s.hash << std::dec << " " << s.bbls << "\n";
+        out << "C" << std::hex;
+        for (size_t i = 0; i < s.checkpoints.size(); ++i)
+            out << " " << s.checkpoints[i];
+        out << std::dec << "\n";
+        for (std::map<std::string, UINT64>::const_iterator it = s.rtnBbls.begin(); it != s.rtnBbls.end(); ++it)
+            out << "F " << it->first << " " << it->second << "\n";
+    }
+}
+
+inline void SelectExpected() {
+    if (st.golden.empty())
+        st.expected = nullptr;
+    else
+        st.expected = &st.golden[std::min<size_t>(st.regions, st.golden.size() - 1)];
+}
+
+// Rutina con mayor diferencia de BBLs contra el golden
+inline std::string WorstRoutine() {
+    std::string worst = "-";
+    UINT64 worstDiff = 0;
+    std::map<std::string, UINT64> names;
+    for (size_t i = 0; i < st.rtnNames.size(); ++i)
+        if (st.rtnCount[i]) names[st.rtnNames[i]] = st.rtnCount[i];
+    for (std::map<std::string, UINT64>::const_iterator it = st.expected->rtnBbls.begin();
+         it != st.expected->rtnBbls.end(); ++it)
+        names.insert(std::make_pair(it->first, 0));
+    for (std::map<std::string, UINT64>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        std::map<std::string, UINT64>::const_iterator g = st.expected->rtnBbls.find(it->first);
+        UINT64 gold = g == st.expected->rtnBbls.end() ? 0 : g->second;
+        UINT64 diff = it->second > gold ? it->second - gold : gold - it->second;
+        if (diff > worstDiff) {
+            worstDiff = diff;
+            worst = it->first;
+        }
+    }
+    return worst;
+}
+
+inline void MarkDivergent() {
+    if (st.diverged)
+        return;
+    st.diverged = true;
+    st.divergedAt = st.cur.bbls;
+    if (st.stopOnDivergence) {
+        st.log << st.regions << "," << st.tag << ",early," << st.divergedAt << "," << st.cur.bbls << ","
+               << (st.expected ? st.expected->bbls : 0) << "," << WorstRoutine() << std::endl;
+        std::cerr << "[CF] Divergencia en region " << st.regions << " BBL " << st.divergedAt
+                  << ", termino la corrida" << std::endl;
+        PIN_ExitApplication(EXIT_DIVERGENT);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+// Analisis
+// ------------------------------------------------------------------------------------------------
+inline ADDRINT PIN_FAST_ANALYSIS_CALL IsActive(THREADID tid) {
+    return tid == st.owner && (st.func.empty() || st.depth > 0);
+}
+
+inline VOID PIN_FAST_ANALYSIS_CALL OnBbl(ADDRINT offset, UINT32 rtnId) {
+    st.cur.hash = (st.cur.hash ^ offset) * FNV_PRIME;
+    ++st.cur.bbls;
+    ++st.rtnCount[rtnId];
+    if (st.cur.bbls % st.interval != 0)
+        return;
+    if (st.record) {
+        st.cur.checkpoints.push_back(st.cur.hash);
+        return;
+    }
+    if (st.expected && !st.diverged) {
+        size_t idx = st.cur.bbls / st.interval - 1;
+        if (idx >= st.expected->checkpoints.size() || st.expected->checkpoints[idx] != st.cur.hash)
+            MarkDivergent();
+    }
+}
+
+inline VOID EnterFunc() { ++st.depth; }
+inline VOID ExitFunc()  { if (st.depth) --st.depth; }
+
+// ------------------------------------------------------------------------------------------------
+// API
+// ------------------------------------------------------------------------------------------------
+// mode: "off", "record" o "compare"
+inline bool Init(const std::string& mode, const std::string& func, const std::string& goldenFile,
+                 const std::string& logFile, UINT64 interval, bool stop) {
+    if (mode == "off")
+        return true;
+    if (mode != "record" && mode != "compare") {
+        std::cerr << "[ERROR] cf_mode desconocido: " << mode << std::endl;
+        return false;
+    }
+    st.enabled = true;
+    st.record = mode == "record";
+    st.func = func;
+    st.goldenFile = goldenFile;
+    st.interval = interval ? interval : 1;
+    st.stopOnDivergence = stop && !st.record;
+    if (!st.record) {
+        if (!LoadGolden(goldenFile))
+            return false;
+        st.log.open(logFile.c_str());
+        st.log << "region,fault,outcome,first_divergent_bbl,bbls,golden_bbls,routine\n";
+    }
+    SelectExpected();
+    return true;
+}
+
+inline VOID InstrumentTrace(TRACE trace) {
+    if (!st.enabled)
+        return;
+    RTN rtn = TRACE_Rtn(trace);
+    std::string name = RTN_Valid(rtn) ? RTN_Name(rtn) : "unknown";
+    ADDRINT base = RTN_Valid(rtn) ? IMG_LowAddress(SEC_Img(RTN_Sec(rtn))) : 0;
+    UINT32 id = RoutineId(name);
+    for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+        BBL_InsertIfCall(bbl, IPOINT_BEFORE, AFUNPTR(IsActive), IARG_FAST_ANALYSIS_CALL, IARG_THREAD_ID, IARG_END);
+        BBL_InsertThenCall(bbl, IPOINT_BEFORE, AFUNPTR(OnBbl), IARG_FAST_ANALYSIS_CALL,
+                           IARG_ADDRINT, BBL_Address(bbl) - base, IARG_UINT32, id, IARG_END);
+    }
+}
+
+// Llamar con cada RTN de la imagen (desde el callback de IMG) para acotar a func
+inline VOID InstrumentRtn(RTN rtn) {
+    if (!st.enabled || st.func.empty() || RTN_Name(rtn) != st.func)
+        return;
+    RTN_Open(rtn);
+    RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(EnterFunc), IARG_END);
+    RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(ExitFunc), IARG_END);
+    RTN_Close(rtn);
+}
+
+// Abre una region nueva y descarta lo acumulado. tag identifica el fault en el
+// log (sin comas, ej. "coeff:bit").
+inline VOID BeginRegion(const std::string& tag) {
+    st.tag = tag;
+    st.cur = Signature();
+    st.depth = 0;
+    st.owner = PIN_ThreadId();
+    st.diverged = false;
+    for (size_t i = 0; i < st.rtnCount.size(); ++i)
+        st.rtnCount[i] = 0;
+}
+
+// Cierra la region actual. Devuelve true si diverge del golden.
+inline bool EndRegion() {
+    if (!st.enabled)
+        return false;
+    bool divergent = false;
+    if (st.record) {
+        for (size_t i = 0; i < st.rtnNames.size(); ++i)
+            if (st.rtnCount[i]) st.cur.rtnBbls[st.rtnNames[i]] = st.rtnCount[i];
+        st.recorded.push_back(st.cur);
+    }
+    else if (st.expected) {
+        if (st.cur.bbls != st.expected->bbls || st.cur.hash != st.expected->hash)
+            MarkDivergent();
+        divergent = st.diverged;
+        if (divergent)
+            ++st.divergentRegions;
+        st.log << st.regions << "," << st.tag << "," << (divergent ? "divergent" : "same") << ","
+               << (divergent ? st.divergedAt : 0) << "," << st.cur.bbls << "," << st.expected->bbls << ","
+               << (divergent ? WorstRoutine() : "-") << "\n";
+    }
+    ++st.regions;
+    SelectExpected();
+    BeginRegion("-");
+    return divergent;
+}
+
+inline VOID Fini() {
+    if (!st.enabled)
+        return;
+    if (st.record) {
+        SaveGolden();
+        std::cerr << "[CF] Golden con " << st.recorded.size() << " regiones en " << st.goldenFile << std::endl;
+    }
+    else
+        std::cerr << "[CF] " << st.divergentRegions << " de " << st.regions << " regiones divergentes" << std::endl;
+}
+
+} // namespace cfsig
+#endif
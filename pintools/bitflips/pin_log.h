@@ -0,0 +1,267 @@
+#ifndef PIN_LOG_MATI_H
+#define PIN_LOG_MATI_H
+
+// Logging con buffer para las pintools, la version Pin de src/async_log.h.
+//
+//   pinlog::Init("");            // stderr; Init(path) para un archivo
+//   PLOG_DEBUG("[DBG] DoBitFlip coeff=" << c);
+//   ...
+//   pinlog::Fini();              // al final del Fini de la tool
+//
+// Cada hilo de la aplicacion escribe en su ring (TLS de Pin, un productor y un
+// consumidor, sin locks). Un hilo interno de Pin los vacia cada 10 ms con un
+// write por ring; PrepareForFini lo detiene y Fini vacia lo que quede.
+// Si la aplicacion recibe SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM o
+// SIGINT se vacia antes de entregarle la señal; un ring que no se pudo tomar
+// (otro hilo lo estaba vaciando) se saltea. Pasados MAX_THREADS hilos, los
+// nuevos escriben sincronico.
+//
+// Los niveles por debajo de PIN_LOG_LEVEL (0 trace .. 4 error, por defecto 2;
+// PIN_LOG_LEVEL del makefile) no generan codigo.
+//
+// Header-only y sin excepciones, como cf_signature.h.
+
+#include "pin.H"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifndef PIN_LOG_LEVEL
+#define PIN_LOG_LEVEL 2
+#endif
+
+namespace pinlog {
+
+static const size_t RING_SIZE = 1 << 20;   // bytes por hilo, potencia de 2
+static const UINT32 MAX_THREADS = 256;
+
+struct Ring {
+    std::atomic<UINT64> head{0};   // productor
+    std::atomic<UINT64> tail{0};   // consumidor
+    std::atomic<bool> draining{false};
+    bool registered = false;       // lo vacia el hilo escritor
+    std::ostringstream fmt;
+    char data[RING_SIZE];
+};
+
+struct State {
+    int fd = STDERR_FILENO;
+    TLS_KEY key;
+    std::atomic<Ring*> rings[MAX_THREADS];
+    std::atomic<UINT32> ringCount{0};
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+    PIN_THREAD_UID writerUid;
+    bool initialized = false;
+};
+
+inline State& state() {
+    static State s;
+    return s;
+}
+
+// writev no esta garantizado en PinCRT: write hasta vaciar cada parte
+inline bool WriteAll(int fd, const char* p, size_t len) {
+    while (len) {
+        ssize_t w = write(fd, p, len);
+        if (w <= 0)
+            return false;
+        p += w;
+        len -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+inline VOID Drain(Ring& ring) {
+    UINT64 head = ring.head.load(std::memory_order_acquire);
+    UINT64 tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail == head)
+        return;
+    size_t start = tail & (RING_SIZE - 1);
+    size_t len = head - tail;
+    size_t first = std::min(len, RING_SIZE - start);
+    if (WriteAll(state().fd, ring.data + start, first) && first < len)
+        WriteAll(state().fd, ring.data, len - first);
+    ring.tail.store(head, std::memory_order_release);
+}
+
+inline bool LockRing(Ring& ring, INT64 spins) {
+    for (INT64 i = 0; spins < 0 || i < spins; ++i) {
+        bool expected = false;
+        if (ring.draining.compare_exchange_weak(expected, true, std::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
+// Sin escritor (antes de Init, durante Fini o ring sin registrar) vacia el productor
+inline VOID SelfDrain(Ring& ring) {
+    LockRing(ring, -1);
+    Drain(ring);
+    ring.draining.store(false, std::memory_order_release);
+}
+
+inline VOID DrainAll(INT64 spins) {
+    State& s = state();
+    UINT32 n = s.ringCount.load(std::memory_order_acquire);
+    for (UINT32 i = 0; i < n; ++i) {
+        Ring* ring = s.rings[i].load(std::memory_order_acquire);
+        if (!ring)
+            continue;
+        // Desde una señal con el ring tomado por otro hilo: mejor perder lineas que mezclarlas
+        if (!LockRing(*ring, spins))
+            continue;
+        Drain(*ring);
+        ring->draining.store(false, std::memory_order_release);
+    }
+}
+
+inline VOID WriterThread(VOID*) {
+    State& s = state();
+    while (!s.stopping.load(std::memory_order_acquire) && !PIN_IsProcessExiting()) {
+        DrainAll(-1);
+        PIN_Sleep(10);
+    }
+    DrainAll(-1);
+    PIN_ExitThread(0);
+}
+
+inline VOID PrepareForFini(VOID*) {
+    State& s = state();
+    s.stopping.store(true, std::memory_order_release);
+    if (s.running.exchange(false))
+        PIN_WaitForThreadTermination(s.writerUid, PIN_INFINITE_TIMEOUT, nullptr);
+}
+
+inline BOOL OnAppSignal(THREADID, INT32, CONTEXT*, BOOL, const EXCEPTION_INFO*, VOID*) {
+    DrainAll(1 << 20);
+    return TRUE;   // la aplicacion recibe la señal igual
+}
+
+inline Ring& LocalRing() {
+    State& s = state();
+    THREADID tid = PIN_ThreadId();
+    if (!s.initialized || tid == INVALID_THREADID) {
+        // Antes de Init o desde main antes de PIN_StartProgram: sincronico
+        static Ring early;
+        return early;
+    }
+    Ring* ring = static_cast<Ring*>(PIN_GetThreadData(s.key, tid));
+    if (ring)
+        return *ring;
+    ring = new Ring();
+    PIN_SetThreadData(s.key, ring, tid);
+    UINT32 slot = s.ringCount.load(std::memory_order_relaxed);
+    while (slot < MAX_THREADS &&
+           !s.ringCount.compare_exchange_weak(slot, slot + 1, std::memory_order_acq_rel))
+        ;
+    if (slot >= MAX_THREADS) {
+        std::cerr << "[WARN] pin_log: mas de " << MAX_THREADS << " hilos, el resto escribe sincronico" << std::endl;
+        return *ring;
+    }
+    ring->registered = true;
+    s.rings[slot].store(ring, std::memory_order_release);
+    return *ring;
+}
+
+inline VOID Push(Ring& ring, const char* msg, size_t len) {
+    State& s = state();
+    len = std::min(len, RING_SIZE - 2);
+    UINT64 head = ring.head.load(std::memory_order_relaxed);
+    while (RING_SIZE - (head - ring.tail.load(std::memory_order_acquire)) < len + 1) {
+        if (!s.running.load(std::memory_order_acquire) || !ring.registered) {
+            SelfDrain(ring);
+            continue;
+        }
+        PIN_Yield();
+    }
+    size_t start = head & (RING_SIZE - 1);
+    size_t first = std::min(len, RING_SIZE - start);
+    std::memcpy(ring.data + start, msg, first);
+    std::memcpy(ring.data, msg + first, len - first);
+    ring.data[(head + len) & (RING_SIZE - 1)] = '\n';
+    ring.head.store(head + len + 1, std::memory_order_release);
+    if (!ring.registered)
+        SelfDrain(ring);
+}
+
+inline VOID Emit(Ring& ring) {
+    std::string msg = ring.fmt.str();
+    Push(ring, msg.data(), msg.size());
+    ring.fmt.str(std::string());
+    ring.fmt.flags(std::ios_base::skipws | std::ios_base::dec);   // un std::hex no pasa a la linea siguiente
+}
+
+// Llamar desde main antes de PIN_StartProgram. path vacio: stderr
+inline bool Init(const std::string& path) {
+    State& s = state();
+    if (s.initialized)
+        return true;
+    if (!path.empty()) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "[ERROR] No pude abrir el log " << path << std::endl;
+            return false;
+        }
+        s.fd = fd;
+    }
+    s.key = PIN_CreateThreadDataKey(nullptr);
+    for (INT32 sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM, SIGINT})
+        PIN_InterceptSignal(sig, OnAppSignal, nullptr);
+    PIN_AddPrepareForFiniFunction(PrepareForFini, nullptr);
+    s.running.store(true, std::memory_order_release);
+    if (PIN_SpawnInternalThread(WriterThread, nullptr, 0, &s.writerUid) == INVALID_THREADID) {
+        std::cerr << "[WARN] pin_log: sin hilo escritor, el buffer se vacia al llenarse y en Fini" << std::endl;
+        s.running.store(false, std::memory_order_release);
+    }
+    s.initialized = true;
+    return true;
+}
+
+// Vacia todo y cierra el archivo. Llamar al final del Fini de la tool.
+inline VOID Fini() {
+    State& s = state();
+    DrainAll(-1);
+    if (s.fd != STDERR_FILENO) {
+        close(s.fd);
+        s.fd = STDERR_FILENO;
+    }
+}
+
+}  // namespace pinlog
+
+#define PIN_LOG_EMIT(msg)                               \
+    do {                                                \
+        pinlog::Ring& pinLogRing_ = pinlog::LocalRing(); \
+        pinLogRing_.fmt << msg;                         \
+        pinlog::Emit(pinLogRing_);                      \
+    } while (0)
+
+#if PIN_LOG_LEVEL <= 0
+#define PLOG_TRACE(msg) PIN_LOG_EMIT(msg)
+#else
+#define PLOG_TRACE(msg) ((void)0)
+#endif
+#if PIN_LOG_LEVEL <= 1
+#define PLOG_DEBUG(msg) PIN_LOG_EMIT(msg)
+#else
+#define PLOG_DEBUG(msg) ((void)0)
+#endif
+#if PIN_LOG_LEVEL <= 2
+#define PLOG_INFO(msg) PIN_LOG_EMIT(msg)
+#else
+#define PLOG_INFO(msg) ((void)0)
+#endif
+#if PIN_LOG_LEVEL <= 3
+#define PLOG_WARN(msg) PIN_LOG_EMIT(msg)
+#else
+#define PLOG_WARN(msg) ((void)0)
+#endif
+#define PLOG_ERROR(msg) PIN_LOG_EMIT(msg)
+
+#endif
@@ -5,6 +5,9 @@
 #include <iostream>
 #include <vector>
 #include <bitset>
+#include "../../src/fault_model.h"
+#include "cf_signature.h"
+#include "pin_log.h"
 
 // ------------------------------------------------------------------------------------------------
 // Knobs
@@ -41,10 +44,38 @@ static KNOB<BOOL> KnobVerbose(
     KNOB_MODE_WRITEONCE, "pintool", "verbose", "1",
     "Habilitar logs de depuración");
 
+static KNOB<std::string> KnobFaultModel(
+    KNOB_MODE_WRITEONCE, "pintool", "fault_model", "bit",
+    "Modelo de fault: bit, burst:w, multi:w, stuck0, stuck1, byte, word");
+
 static KNOB<BOOL> KnobFullRestore(
     KNOB_MODE_WRITEONCE, "pintool", "full_restore", "0",
     "Restaurar todos los coeficientes (1) o solo los modificados (0)");
 
+static KNOB<std::string> KnobCfMode(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_mode", "off",
+    "Firma de flujo de control por iteración: off, record (golden, con -enable_effect 0) o compare");
+
+static KNOB<std::string> KnobCfFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_func", "",
+    "Función medida para la firma (vacío: toda la iteración)");
+
+static KNOB<std::string> KnobCfGolden(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_golden", "cf_golden.txt",
+    "Fichero con las firmas golden");
+
+static KNOB<std::string> KnobCfLog(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_log", "cf_divergence.csv",
+    "CSV con la comparación de cada iteración contra el golden");
+
+static KNOB<UINT64> KnobCfInterval(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_interval", "4096",
+    "BBLs entre checkpoints del hash para detectar la divergencia en vivo");
+
+static KNOB<BOOL> KnobCfStop(
+    KNOB_MODE_WRITEONCE, "pintool", "cf_stop", "0",
+    "Terminar la corrida en la primera divergencia (código de salida 3)");
+
 // ------------------------------------------------------------------------------------------------
 // Types & Globals
 // ------------------------------------------------------------------------------------------------
@@ -59,19 +90,22 @@ static UINT32  curBit        = 0;
 static bool    flipPending   = false;
 static bool    flipApplied   = false;
 static std::vector<UINT64> origCoeffs;
+static faultmodel::Model faultModel;
+static std::vector<faultmodel::WordMask> faultMasks;
+static faultmodel::DenseMask faultDense;
 
 // Performance optimizations
 static std::bitset<8192> modifiedCoeffs; // Track which coeffs were modified (max 8192)
 static UINT64* coeffArray = nullptr;      // Direct pointer to coefficient array
 static bool formatFuncAffectsAll = true; // Assume format affects all until we know better
 
-// Logging optimizado
+// Logging con buffer (pin_log.h), a stderr
 #define VLOG(msg) \
-    do { if (KnobVerbose) std::cerr << msg << std::endl; } while (0)
+    do { if (KnobVerbose) PLOG_INFO(msg); } while (0)
 
-// Logging ligero para operaciones frecuentes
+// Logging por fault: nivel debug, sin -DPIN_LOG_LEVEL=1 (PIN_LOG_LEVEL del makefile) no genera codigo
 #define VLOG_LIGHT(msg) \
-    do { if (KnobVerbose.Value() ) std::cerr << msg << std::endl; } while (0)
+    do { if (KnobVerbose.Value() ) PLOG_DEBUG(msg); } while (0)
 
 // ------------------------------------------------------------------------------------------------
 // Helpers
@@ -90,10 +124,20 @@ bool ReadAddresses() {
         return false;
     }
     unsigned long long obj=0, base=0;
-    if (sscanf(buf, "%llx %llx", &obj, &base) != 2) {
+    char modelSpec[32] = {};
+    int fields = sscanf(buf, "%llx %llx %31s", &obj, &base, modelSpec);
+    if (fields < 2) {
         std::cerr << "[ERROR] Formato inválido en " << KnobAddrFile.Value() << std::endl;
         return false;
     }
+    // Tercera linea (opcional): el modelo del driver, tiene que ser el de -fault_model
+    faultmodel::Model driverModel;
+    if (fields == 3 && (!faultmodel::parse(modelSpec, driverModel) ||
+                        faultmodel::name(driverModel) != faultmodel::name(faultModel))) {
+        std::cerr << "[ERROR] El driver usa faultModel=" << modelSpec << " y el pintool -fault_model "
+                  << faultmodel::name(faultModel) << std::endl;
+        PIN_ExitApplication(1);
+    }
     objectAddr = (ADDRINT)obj;
     baseAddr   = (ADDRINT)base;
     coeffArray = reinterpret_cast<UINT64*>(baseAddr); // Cache direct pointer
@@ -139,6 +183,11 @@ inline void VerifyCleanState() {
     }
 }
 
+// Fault de la iteración actual, para el log de flujo de control
+inline std::string CurrentFaultTag() {
+    return std::to_string(curCoeff) + ":" + std::to_string(curBit);
+}
+
 // ------------------------------------------------------------------------------------------------
 // Callbacks
 // ------------------------------------------------------------------------------------------------
@@ -180,13 +229,17 @@ VOID DoBitFlip() {
         CallFormat();
     }
 
-    // PASO 3: Apply bitflip
+    // PASO 3: Apply fault (puede tocar coeficientes vecinos: burst, multi).
+    // Stuck-at mira la palabra que se pisa, ya en el formato de despues de CallFormat
     if (KnobEnableEffect) {
-        UINT64 mask = (1ULL << curBit);
-        coeffArray[curCoeff] ^= mask;
-        modifiedCoeffs[curCoeff] = true; // Mark as modified
-
-        VLOG_LIGHT("[DBG] Flipped bit " << curBit << " of coeff " << curCoeff);
+        faultmodel::generate(faultModel, coeffArray, KnobNumCoeffs.Value(), curCoeff, curBit, faultMasks);
+        faultmodel::densify(faultMasks, faultDense);
+        faultmodel::applyXor(coeffArray, faultDense);
+        for (size_t i = 0; i < faultDense.masks.size(); ++i)
+            modifiedCoeffs[faultDense.first + i] = true; // Mark as modified
+
+        VLOG_LIGHT("[DBG] Fault " << faultmodel::name(faultModel) << " at bit " << curBit
+                   << " of coeff " << curCoeff);
     }
 
     // PASO 4: Format AFTER
@@ -207,7 +260,7 @@ VOID RestoreAndAdvance() {
 
     // PASO 2: Advance to next bit/coefficient
     if (curCoeff < KnobNumCoeffs) {
-        curBit++;
+        curBit += faultmodel::bitStride(faultModel);
         if (curBit >= 64) {
             curBit = 0;
             curCoeff++;
@@ -237,7 +290,10 @@ VOID RestoreAndAdvance() {
 // Stubs en la app
 // ------------------------------------------------------------------------------------------------
 VOID OnSyncMarker() {
+    if (cfsig::EndRegion())
+        VLOG_LIGHT("[DBG] Flujo de control divergente en coeff=" << curCoeff << " bit=" << curBit);
     RestoreAndAdvance();
+    cfsig::BeginRegion(CurrentFaultTag());
 }
 
 VOID OnLabelHit() {
@@ -277,6 +333,7 @@ VOID OnLabelHit() {
     curBit = 0;
     flipPending = true;
     flipApplied = false;
+    cfsig::BeginRegion(CurrentFaultTag());
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -286,6 +343,7 @@ VOID ImageCallback(IMG img, VOID*) {
     for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
         for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
             std::string name = RTN_Name(rtn);
+            cfsig::InstrumentRtn(rtn);
 
             if (name == KnobLabel.Value()) {
                 RTN_Open(rtn);
@@ -319,10 +377,15 @@ VOID ImageCallback(IMG img, VOID*) {
     }
 }
 
+VOID Trace(TRACE trace, VOID*) {
+    cfsig::InstrumentTrace(trace);
+}
+
 VOID Fini(INT32, VOID*) {
+    cfsig::Fini();
     VLOG("[DBG] === FINAL STATE ===");
     VLOG("[DBG] Processed " << curCoeff << " coefficients, "
-         << (curCoeff * 64 + curBit) << " total bits");
+         << (curCoeff * 64 + curBit) << " total bits, model " << faultmodel::name(faultModel));
 
     if (addressRead && KnobVerbose.Value() ) {
         VLOG("[DBG] Final verification of first 8 coefficients:");
@@ -331,12 +394,25 @@ VOID Fini(INT32, VOID*) {
                  << " (orig: 0x" << origCoeffs[i] << ")" << std::dec);
         }
     }
+    pinlog::Fini();
 }
 
 int main(int argc, char* argv[]) {
     if (PIN_Init(argc, argv)) return 1;
+    if (!faultmodel::parse(KnobFaultModel.Value(), faultModel)) {
+        std::cerr << "[ERROR] fault_model desconocido: " << KnobFaultModel.Value() << std::endl;
+        return 1;
+    }
+    if (!cfsig::Init(KnobCfMode.Value(), KnobCfFunc.Value(), KnobCfGolden.Value(), KnobCfLog.Value(),
+                     KnobCfInterval.Value(), KnobCfStop.Value())) {
+        return 1;
+    }
+    if (!pinlog::Init(""))
+        return 1;
     PIN_InitSymbols();
     IMG_AddInstrumentFunction(ImageCallback, nullptr);
+    if (KnobCfMode.Value() != "off")
+        TRACE_AddInstrumentFunction(Trace, nullptr);
     PIN_AddFiniFunction(Fini, nullptr);
     PIN_StartProgram();
     return 0;
@@ -0,0 +1,284 @@
+#include "pin.H"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "../../src/fault_model.h"
+
+// Fault campaign on the double-precision stage of CKKS encode/decode
+// (CKKSPackedEncoding::Encode/Decode run a complex FFT on doubles before
+// scaling to integers). A site is the N-th dynamic double produced inside
+// the target routine, either:
+//   - reg: the low double of the XMM destination of MULSD/ADDSD/VFMADD...
+//   - mem: the 8-byte slot written by a store of a double
+// and the bit is drawn from a class (sign, exponent, mantissa). The app calls
+// sync_marker after every encode/decode; each call moves to the next bit of
+// the class and, once the class is exhausted, to the next site. Thousands of
+// faults run in one process instead of paying OpenFHE startup for each.
+
+// ------------------------------------------------------------------------------------------------
+// Knobs
+// ------------------------------------------------------------------------------------------------
+static KNOB<std::string> KnobTargetFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "func", "",
+    "Encode or Decode routine to attack (mangled name)");
+
+static KNOB<std::string> KnobMode(
+    KNOB_MODE_WRITEONCE, "pintool", "mode", "reg",
+    "reg: XMM destinations of FP arithmetic, mem: stored double slots");
+
+static KNOB<std::string> KnobBitClass(
+    KNOB_MODE_WRITEONCE, "pintool", "bit_class", "all",
+    "Bits to sweep at each site: sign, exponent, mantissa or all");
+
+static KNOB<UINT64> KnobFirstSite(
+    KNOB_MODE_WRITEONCE, "pintool", "site", "0",
+    "First site (N-th dynamic FP result inside the routine, 0-based)");
+
+static KNOB<UINT64> KnobSiteStep(
+    KNOB_MODE_WRITEONCE, "pintool", "site_step", "1",
+    "Sites skipped once all bits of the class were flipped");
+
+static KNOB<std::string> KnobLabel(
+    KNOB_MODE_WRITEONCE, "pintool", "label", "addr_label",
+    "Stub that arms the injector (golden runs before it are not touched)");
+
+static KNOB<std::string> KnobFaultModel(
+    KNOB_MODE_WRITEONCE, "pintool", "fault_model", "bit",
+    "Fault model (src/fault_model.h) starting at each swept bit of the double; multi:w is one bit here");
+
+static KNOB<std::string> KnobLogFile(
+    KNOB_MODE_WRITEONCE, "pintool", "log", "fft_fault.log",
+    "One line per iteration: iter,site,ip,bit,class,mask");
+
+// ------------------------------------------------------------------------------------------------
+// Globals
+// ------------------------------------------------------------------------------------------------
+// IEEE-754 binary64: mantissa [0,51], exponent [52,62], sign 63
+static UINT32  classFirstBit = 0;
+static UINT32  classLastBit  = 63;
+
+static ADDRINT armed         = 0;
+static ADDRINT insideTarget  = 0;
+static UINT32  activeDepth   = 0;
+static UINT64  siteCount     = 0;
+static UINT64  targetSite    = 0;      // siteCount value that fires, 0 once fired
+static UINT64  curSite       = 0;      // site of the current iteration (0-based)
+static UINT32  curBit        = 0;
+static faultmodel::Model faultModel;
+static UINT64  iteration     = 0;
+static BOOL    injected      = FALSE;
+static ADDRINT faultPending  = 0;
+static ADDRINT pendingEA     = 0;
+
+static std::ofstream logfile;
+
+// ------------------------------------------------------------------------------------------------
+// Classification
+// ------------------------------------------------------------------------------------------------
+static bool IsDoubleArith(INS ins) {
+    switch (INS_Opcode(ins)) {
+        case XED_ICLASS_ADDSD:  case XED_ICLASS_SUBSD:  case XED_ICLASS_MULSD:
+        case XED_ICLASS_ADDPD:  case XED_ICLASS_SUBPD:  case XED_ICLASS_MULPD:
+        case XED_ICLASS_VADDSD: case XED_ICLASS_VSUBSD: case XED_ICLASS_VMULSD:
+        case XED_ICLASS_VADDPD: case XED_ICLASS_VSUBPD: case XED_ICLASS_VMULPD:
+        case XED_ICLASS_VFMADD132SD: case XED_ICLASS_VFMADD213SD: case XED_ICLASS_VFMADD231SD:
+        case XED_ICLASS_VFMADD132PD: case XED_ICLASS_VFMADD213PD: case XED_ICLASS_VFMADD231PD:
+        case XED_ICLASS_VFMSUB132SD: case XED_ICLASS_VFMSUB213SD: case XED_ICLASS_VFMSUB231SD:
+        case XED_ICLASS_VFNMADD132SD: case XED_ICLASS_VFNMADD213SD: case XED_ICLASS_VFNMADD231SD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Store of a double (or a std::complex<double>) held in an XMM register
+static bool IsDoubleStore(INS ins) {
+    if (!INS_IsMemoryWrite(ins) || !INS_hasKnownMemorySize(ins))
+        return false;
+    switch (INS_Opcode(ins)) {
+        case XED_ICLASS_MOVSD_XMM: case XED_ICLASS_VMOVSD:
+        case XED_ICLASS_MOVAPD:    case XED_ICLASS_VMOVAPD:
+        case XED_ICLASS_MOVUPD:    case XED_ICLASS_VMOVUPD:
+        case XED_ICLASS_MOVLPD:    case XED_ICLASS_VMOVLPD:
+        case XED_ICLASS_MOVQ:      case XED_ICLASS_VMOVQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool ResolveBitClass(const std::string& name) {
+    if (name == "sign")          { classFirstBit = 63; classLastBit = 63; }
+    else if (name == "exponent") { classFirstBit = 52; classLastBit = 62; }
+    else if (name == "mantissa") { classFirstBit = 0;  classLastBit = 51; }
+    else if (name == "all")      { classFirstBit = 0;  classLastBit = 63; }
+    else return false;
+    return true;
+}
+
+static const char* BitClassOf(UINT32 bit) {
+    if (bit == 63) return "sign";
+    if (bit >= 52) return "exponent";
+    return "mantissa";
+}
+
+// ------------------------------------------------------------------------------------------------
+// Analysis
+// ------------------------------------------------------------------------------------------------
+ADDRINT PIN_FAST_ANALYSIS_CALL CountSite() {
+    siteCount += insideTarget & armed;
+    return insideTarget & armed & (siteCount == targetSite);
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsPending() {
+    return faultPending;
+}
+
+static VOID LogInjection(ADDRINT ip, UINT64 mask) {
+    logfile << iteration << "," << curSite << ",0x" << std::hex << ip << std::dec << ","
+            << curBit << "," << BitClassOf(curBit) << ",0x" << std::hex << mask << std::dec << "\n";
+    injected   = TRUE;
+    targetSite = 0;
+}
+
+VOID MarkPendingReg() {
+    faultPending = 1;
+}
+
+VOID FlipRegister(ADDRINT ip, PIN_REGISTER* value) {
+    faultPending = 0;
+    UINT64 mask = faultmodel::xorValue(faultModel, value->byte, sizeof(UINT64), curBit);
+    LogInjection(ip, mask);
+}
+
+VOID MarkPendingStore(ADDRINT ea) {
+    faultPending = 1;
+    pendingEA = ea;
+}
+
+VOID FlipStore(ADDRINT ip) {
+    faultPending = 0;
+    UINT64 mask = faultmodel::xorValue(faultModel, reinterpret_cast<UINT8*>(pendingEA), sizeof(UINT64), curBit);
+    LogInjection(ip, mask);
+}
+
+VOID EnterTarget() {
+    if (activeDepth++ == 0) siteCount = 0;
+    insideTarget = 1;
+}
+
+VOID ExitTarget() {
+    if (activeDepth > 0) --activeDepth;
+    insideTarget = activeDepth > 0 ? 1 : 0;
+}
+
+VOID OnLabelHit() {
+    armed = 1;
+}
+
+// End of one encode/decode: next bit of the class, then next site
+VOID OnSyncMarker() {
+    if (!injected)
+        logfile << iteration << "," << curSite << ",NOT_REACHED,,\n";
+    injected = FALSE;
+    ++iteration;
+    if (++curBit > classLastBit) {
+        curBit = classFirstBit;
+        curSite += KnobSiteStep.Value();
+    }
+    targetSite = curSite + 1;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Instrumentation
+// ------------------------------------------------------------------------------------------------
+VOID InstrumentReg(INS ins) {
+    if (!IsDoubleArith(ins) || !INS_IsValidForIpointAfter(ins))
+        return;
+    REG dest = INS_OperandReg(ins, 0);
+    if (!REG_is_xmm(dest) && !REG_is_ymm(dest))
+        return;
+    INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(CountSite), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(MarkPendingReg), IARG_END);
+    INS_InsertIfCall(ins, IPOINT_AFTER, AFUNPTR(IsPending), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_AFTER, AFUNPTR(FlipRegister),
+                       IARG_INST_PTR, IARG_REG_REFERENCE, dest, IARG_END);
+}
+
+VOID InstrumentMem(INS ins) {
+    if (!IsDoubleStore(ins) || !INS_IsValidForIpointAfter(ins))
+        return;
+    INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(CountSite), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(MarkPendingStore), IARG_MEMORYWRITE_EA, IARG_END);
+    INS_InsertIfCall(ins, IPOINT_AFTER, AFUNPTR(IsPending), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_AFTER, AFUNPTR(FlipStore), IARG_INST_PTR, IARG_END);
+}
+
+VOID Instruction(INS ins, VOID*) {
+    if (KnobMode.Value() == "mem")
+        InstrumentMem(ins);
+    else
+        InstrumentReg(ins);
+}
+
+VOID ImageCallback(IMG img, VOID*) {
+    for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
+        for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
+            std::string name = RTN_Name(rtn);
+            if (name == KnobTargetFunc.Value()) {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(EnterTarget), IARG_END);
+                RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(ExitTarget), IARG_END);
+                RTN_Close(rtn);
+            }
+            else if (name == KnobLabel.Value()) {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnLabelHit), IARG_END);
+                RTN_Close(rtn);
+            }
+            else if (name == "sync_marker") {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnSyncMarker), IARG_END);
+                RTN_Close(rtn);
+            }
+        }
+    }
+}
+
+VOID Fini(INT32, VOID*) {
+    logfile.close();
+    std::cerr << "[INFO] " << iteration << " iterations, last site " << curSite
+              << " bit " << curBit << std::endl;
+}
+
+INT32 Usage() {
+    std::cerr << "CKKS encode/decode FFT fault campaign Pin tool" << std::endl;
+    std::cerr << KNOB_BASE::StringKnobSummary() << std::endl;
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    PIN_InitSymbols();
+    if (PIN_Init(argc, argv)) return Usage();
+
+    if (KnobTargetFunc.Value().empty() || !ResolveBitClass(KnobBitClass.Value())) {
+        std::cerr << "[ERROR] func is required and bit_class must be sign, exponent, mantissa or all" << std::endl;
+        return Usage();
+    }
+    if (!faultmodel::parse(KnobFaultModel.Value(), faultModel)) {
+        std::cerr << "[ERROR] unknown fault_model " << KnobFaultModel.Value() << std::endl;
+        return Usage();
+    }
+    curSite    = KnobFirstSite.Value();
+    curBit     = classFirstBit;
+    targetSite = curSite + 1;
+
+    logfile.open(KnobLogFile.Value().c_str());
+    logfile << "iter,site,ip,bit,class,mask\n";
+
+    IMG_AddInstrumentFunction(ImageCallback, nullptr);
+    INS_AddInstrumentFunction(Instruction, nullptr);
+    PIN_AddFiniFunction(Fini, nullptr);
+    PIN_StartProgram();
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "pin.H"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include "../../src/fault_model.h"
+
+// Fault model: transient corruption of the value moving through the load/store
+// unit. The N-th dynamic memory access executed while the target routine is
+// active gets one fault of -fault_model (default one bit flipped) at -bit,
+// applied to the 64-bit word of the access that holds that bit:
+//   - load : the bit is flipped in memory right before the load and (by default)
+//            restored right after it, so only the loaded register sees the fault.
+//            The restore only XORs the mask back if the word still holds the
+//            faulted value, and is skipped when the instruction itself writes
+//            those bytes (add [mem], r; inc [mem]; xchg; lock-prefixed ops): what
+//            is left in memory is its result, computed from the faulted value.
+//   - store: the bit is flipped in memory right after the store, so the value
+//            that was written is the corrupted one.
+// Counting uses the IfCall/ThenCall fast path: the IfCall routines are
+// branch-free and get inlined by Pin, the ThenCall only runs for the target.
+
+// ------------------------------------------------------------------------------------------------
+// Knobs
+// ------------------------------------------------------------------------------------------------
+static KNOB<std::string> KnobTargetFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "func", "",
+    "Exact (mangled) symbol name of the routine to attack");
+
+static KNOB<UINT64> KnobMemIndex(
+    KNOB_MODE_WRITEONCE, "pintool", "mem_index", "0",
+    "N-th dynamic memory access inside the target routine (0-based)");
+
+static KNOB<std::string> KnobAccess(
+    KNOB_MODE_WRITEONCE, "pintool", "access", "any",
+    "Accesses to count and attack: load, store or any");
+
+static KNOB<UINT32> KnobTargetBit(
+    KNOB_MODE_WRITEONCE, "pintool", "bit", "0",
+    "Bit to flip inside the accessed value (wraps on the access size)");
+
+static KNOB<std::string> KnobFaultModel(
+    KNOB_MODE_WRITEONCE, "pintool", "fault_model", "bit",
+    "Fault model (src/fault_model.h): bit, burst:w, stuck0, stuck1, byte, word; multi:w is one bit here");
+
+static KNOB<BOOL> KnobCallees(
+    KNOB_MODE_WRITEONCE, "pintool", "callees", "1",
+    "Also count accesses of routines called from the target (1) or only its body (0)");
+
+static KNOB<BOOL> KnobTransientLoad(
+    KNOB_MODE_WRITEONCE, "pintool", "transient_load", "1",
+    "Restore memory after a corrupted load (1) or leave it corrupted (0)");
+
+static KNOB<std::string> KnobLogFile(
+    KNOB_MODE_WRITEONCE, "pintool", "log", "memory_fault.log",
+    "Log file path");
+
+// ------------------------------------------------------------------------------------------------
+// Globals
+// ------------------------------------------------------------------------------------------------
+enum AccessKind { ACCESS_LOAD = 1, ACCESS_STORE = 2, ACCESS_ANY = 3 };
+
+static UINT32  accessMask     = ACCESS_ANY;
+static UINT32  activeDepth    = 0;      // Nesting depth of the target routine
+static ADDRINT insideTarget   = 0;      // 1 while the target routine is active
+static UINT64  accessCount    = 0;      // Dynamic accesses seen while inside
+static UINT64  targetAccess   = 0;      // accessCount value that fires (mem_index + 1)
+static BOOL    faultInjected  = FALSE;
+
+// Pending state between IPOINT_BEFORE and IPOINT_AFTER of the target instruction
+static ADDRINT pendingRestore = 0;      // 1 when a load must be restored
+static ADDRINT pendingStore   = 0;      // 1 when a store must be corrupted
+static ADDRINT pendingEA      = 0;
+static UINT32  pendingSize    = 0;
+static UINT32  faultOffset    = 0;      // Byte offset of the faulted word inside the access
+static UINT32  faultLen       = 0;      // Bytes of that word inside the access
+static UINT64  faultMask      = 0;      // Mask applied to the word
+static UINT64  faultedWord    = 0;      // Value of the word right after the fault
+static faultmodel::Model faultModel;
+
+static std::ofstream logfile;
+
+// ------------------------------------------------------------------------------------------------
+// Helpers
+// ------------------------------------------------------------------------------------------------
+static UINT32 ParseAccess(const std::string& s) {
+    if (s == "load")  return ACCESS_LOAD;
+    if (s == "store") return ACCESS_STORE;
+    return ACCESS_ANY;
+}
+
+static VOID FlipAt(ADDRINT ea, UINT32 size) {
+    UINT8* value = reinterpret_cast<UINT8*>(ea);
+    faultMask = faultmodel::xorValue(faultModel, value, size, KnobTargetBit.Value(), &faultOffset);
+    faultLen = std::min<UINT32>(8, size - faultOffset);
+    faultedWord = 0;
+    std::memcpy(&faultedWord, value + faultOffset, faultLen);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Analysis: fast path (inlined)
+// ------------------------------------------------------------------------------------------------
+ADDRINT PIN_FAST_ANALYSIS_CALL CountAccess() {
+    accessCount += insideTarget;
+    return insideTarget & (accessCount == targetAccess);
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsRestorePending() {
+    return pendingRestore;
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsStorePending() {
+    return pendingStore;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Analysis: slow path (only the target access)
+// ------------------------------------------------------------------------------------------------
+// writeSize is 0 when the instruction does not write memory
+VOID FlipLoad(ADDRINT ip, ADDRINT ea, UINT32 size, ADDRINT writeEA, UINT32 writeSize) {
+    FlipAt(ea, size);
+    faultInjected  = TRUE;
+    targetAccess   = 0;           // accessCount is always >= 1 here, never fires again
+    pendingEA      = ea;
+    pendingSize    = size;
+
+    ADDRINT target = ea + faultOffset;
+    bool rmw = writeSize > 0 && target < writeEA + writeSize && writeEA < target + faultLen;
+    pendingRestore = (KnobTransientLoad.Value() && !rmw) ? 1 : 0;
+
+    logfile << "FAULT INJECTED: kind=load access=" << accessCount - 1
+            << " size=" << size << " bit=" << KnobTargetBit.Value() % (size * 8)
+            << " model=" << faultmodel::name(faultModel) << " mask=0x" << std::hex << faultMask
+            << " EA=0x" << ea << " IP=0x" << ip << std::dec
+            << (rmw ? " rmw=1" : "") << std::endl;
+}
+
+VOID RestoreLoad() {
+    UINT8* word = reinterpret_cast<UINT8*>(pendingEA + faultOffset);
+    UINT64 current = 0;
+    std::memcpy(&current, word, faultLen);
+    // Someone else stored to the word in between: that value wins
+    if (current == faultedWord) {
+        current ^= faultMask;
+        std::memcpy(word, &current, faultLen);
+    }
+    pendingRestore = 0;
+}
+
+VOID ArmStore(ADDRINT ip, ADDRINT ea, UINT32 size) {
+    faultInjected = TRUE;
+    targetAccess  = 0;
+    pendingEA     = ea;
+    pendingSize   = size;
+    pendingStore  = 1;
+
+    logfile << "FAULT INJECTED: kind=store access=" << accessCount - 1
+            << " size=" << size << " bit=" << KnobTargetBit.Value() % (size * 8)
+            << " model=" << faultmodel::name(faultModel)
+            << " EA=0x" << std::hex << ea << " IP=0x" << ip << std::dec << std::endl;
+}
+
+VOID FlipStore() {
+    FlipAt(pendingEA, pendingSize);
+    pendingStore = 0;
+}
+
+VOID EnterTarget() {
+    ++activeDepth;
+    insideTarget = 1;
+}
+
+VOID ExitTarget() {
+    if (activeDepth > 0) --activeDepth;
+    insideTarget = activeDepth > 0 ? 1 : 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Instrumentation
+// ------------------------------------------------------------------------------------------------
+// Inserts an IPOINT_AFTER (or taken-branch) IfCall/ThenCall pair
+static VOID InsertAfter(INS ins, AFUNPTR ifFn, AFUNPTR thenFn) {
+    if (INS_IsValidForIpointAfter(ins)) {
+        INS_InsertIfCall(ins, IPOINT_AFTER, ifFn, IARG_FAST_ANALYSIS_CALL, IARG_END);
+        INS_InsertThenCall(ins, IPOINT_AFTER, thenFn, IARG_END);
+    }
+    if (INS_IsValidForIpointTakenBranch(ins)) {
+        INS_InsertIfCall(ins, IPOINT_TAKEN_BRANCH, ifFn, IARG_FAST_ANALYSIS_CALL, IARG_END);
+        INS_InsertThenCall(ins, IPOINT_TAKEN_BRANCH, thenFn, IARG_END);
+    }
+}
+
+static VOID InstrumentMemory(INS ins) {
+    if (INS_IsPrefetch(ins) || !INS_hasKnownMemorySize(ins)) return;
+
+    if ((accessMask & ACCESS_LOAD) && INS_IsMemoryRead(ins)) {
+        INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(CountAccess),
+                         IARG_FAST_ANALYSIS_CALL, IARG_END);
+        if (INS_IsMemoryWrite(ins)) {
+            INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(FlipLoad),
+                               IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
+                               IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE, IARG_END);
+        } else {
+            INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(FlipLoad),
+                               IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
+                               IARG_ADDRINT, ADDRINT(0), IARG_UINT32, 0, IARG_END);
+        }
+        InsertAfter(ins, AFUNPTR(IsRestorePending), AFUNPTR(RestoreLoad));
+    }
+
+    if ((accessMask & ACCESS_STORE) && INS_IsMemoryWrite(ins)) {
+        // The write EA is only available before the instruction executes
+        INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(CountAccess),
+                         IARG_FAST_ANALYSIS_CALL, IARG_END);
+        INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(ArmStore),
+                           IARG_INST_PTR, IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE, IARG_END);
+        InsertAfter(ins, AFUNPTR(IsStorePending), AFUNPTR(FlipStore));
+    }
+}
+
+VOID ImageCallback(IMG img, VOID*) {
+    if (!IMG_IsMainExecutable(img)) return;
+
+    for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
+        for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
+            bool isTarget = (RTN_Name(rtn) == KnobTargetFunc.Value());
+            if (!isTarget && !KnobCallees.Value()) continue;
+
+            RTN_Open(rtn);
+            if (isTarget) {
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(EnterTarget), IARG_END);
+                RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(ExitTarget), IARG_END);
+                logfile << "INSTRUMENTED: Function " << RTN_Name(rtn)
+                        << " at 0x" << std::hex << RTN_Address(rtn) << std::dec << std::endl;
+            }
+            for (INS ins = RTN_InsHead(rtn); INS_Valid(ins); ins = INS_Next(ins)) {
+                InstrumentMemory(ins);
+            }
+            RTN_Close(rtn);
+        }
+    }
+}
+
+VOID Fini(INT32, VOID*) {
+    logfile << "SUMMARY: Target=" << KnobTargetFunc.Value()
+            << " Access=" << KnobAccess.Value()
+            << " MemIndex=" << KnobMemIndex.Value()
+            << " Bit=" << KnobTargetBit.Value()
+            << " FaultInjected=" << (faultInjected ? "YES" : "NO") << std::endl;
+    logfile.close();
+}
+
+INT32 Usage() {
+    std::cerr << "CKKS load/store fault injection Pin tool" << std::endl;
+    std::cerr << "Usage: pin -t pintool_BitFlip_memory.so -func <sym> -mem_index <N>"
+              << " -access load|store|any -bit <b> -- <program>" << std::endl;
+    std::cerr << KNOB_BASE::StringKnobSummary() << std::endl;
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    PIN_InitSymbols();
+    if (PIN_Init(argc, argv)) return Usage();
+
+    if (KnobTargetFunc.Value().empty()) {
+        std::cerr << "Error: func parameter is required" << std::endl;
+        return Usage();
+    }
+
+    if (!faultmodel::parse(KnobFaultModel.Value(), faultModel)) {
+        std::cerr << "Error: unknown fault_model " << KnobFaultModel.Value() << std::endl;
+        return Usage();
+    }
+    accessMask   = ParseAccess(KnobAccess.Value());
+    targetAccess = KnobMemIndex.Value() + 1;
+
+    logfile.open(KnobLogFile.Value().c_str());
+    if (!logfile.is_open()) {
+        std::cerr << "Error: Cannot open log file " << KnobLogFile.Value() << std::endl;
+        return -1;
+    }
+
+    IMG_AddInstrumentFunction(ImageCallback, nullptr);
+    PIN_AddFiniFunction(Fini, nullptr);
+    PIN_StartProgram();
+    return 0;
+}
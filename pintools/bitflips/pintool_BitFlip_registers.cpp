@@ -2,6 +2,11 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include "pin_log.h"
+#include "../../src/fault_model.h"
 
 using namespace std;
 
@@ -13,27 +18,95 @@ KNOB<UINT64> KnobTargetArithOp(KNOB_MODE_WRITEONCE, "pintool",
     "target_arith", "0", "N-th arithmetic operation within target function (0-based)");
 
 KNOB<UINT32> KnobTargetBit(KNOB_MODE_WRITEONCE, "pintool",
-    "target_bit", "0", "Bit position to flip (0-255)");
+    "target_bit", "0", "Bit position to flip (wraps on the register size)");
+
+KNOB<string> KnobFaultModel(KNOB_MODE_WRITEONCE, "pintool",
+    "fault_model", "bit", "Fault model (src/fault_model.h) applied at target_bit; multi:w is one bit in a register");
+KNOB<string> KnobTargetHalf(KNOB_MODE_WRITEONCE, "pintool",
+    "target_half", "any", "Product half to attack: lo, hi or any. lo/hi only count widening multiplies (MUL, IMUL r/m, MULX)");
+
+KNOB<string> KnobTargetReg(KNOB_MODE_WRITEONCE, "pintool",
+    "target_reg", "dest", "Written register to attack: dest (first written GPR/XMM) or a name (rdx, rflags, ...)");
 
 KNOB<string> KnobLogFile(KNOB_MODE_WRITEONCE, "pintool",
     "log", "fault_injection.log", "Log file path");
 
+// Sweep mode: one fault per iteration of the app, delimited by sync_marker
+KNOB<string> KnobLabel(KNOB_MODE_WRITEONCE, "pintool",
+    "label", "", "Stub that arms the injector (empty: armed from the start)");
+
+KNOB<UINT32> KnobBitsPerSite(KNOB_MODE_WRITEONCE, "pintool",
+    "bits_per_site", "1", "Sweep: consecutive bits flipped at each site before moving to the next");
+
+KNOB<UINT64> KnobOpStep(KNOB_MODE_WRITEONCE, "pintool",
+    "op_step", "1", "Sweep: arithmetic ops skipped between sites");
+
+KNOB<string> KnobSiteReport(KNOB_MODE_WRITEONCE, "pintool",
+    "site_report", "", "CSV with per-site vulnerability (needs report_norm in the app)");
+
+KNOB<double> KnobMaskedEps(KNOB_MODE_WRITEONCE, "pintool",
+    "masked_eps", "1e-9", "Norm at or below which a fault counts as masked");
+
+// Half of a 128-bit product a written register holds
+enum ProductHalf { HALF_ANY = 0, HALF_LO = 1, HALF_HI = 2 };
+
+static const char* HalfName(UINT32 half) {
+    switch (half) {
+        case HALF_LO: return "lo";
+        case HALF_HI: return "hi";
+        default:      return "any";
+    }
+}
+
+struct WrittenReg {
+    REG reg;        // full register name (EAX -> RAX)
+    UINT32 bits;    // bits actually written by the instruction
+    ProductHalf half;
+};
+
+// Per-site vulnerability, filled when the app reports the norm of the run
+struct SiteStats {
+    string mnemonic;
+    string reg;
+    UINT32 half = HALF_ANY;
+    UINT64 injections = 0;
+    UINT64 masked = 0;
+    UINT64 nonFinite = 0;
+    double sumNorm = 0;
+    double maxNorm = 0;
+};
+
 // Global variables
 static bool inside_target_function = false;
+static ADDRINT armed = 1;
 static UINT64 arith_ops_in_function = 0;
 static UINT64 target_arith_op_number = 0;
 static UINT32 target_bit = 0;
+static faultmodel::Model fault_model;
+static UINT32 target_half = HALF_ANY;
 static string target_function = "";
-static ofstream logfile;
 static bool fault_injected = false;
+static ADDRINT fault_pending = 0;       // set BEFORE the target op, consumed AFTER it
+static UINT32 bits_done_at_site = 0;
 
-// Check if instruction is arithmetic
+static ADDRINT last_site_ip = 0;
+static map<ADDRINT, SiteStats> sites;
+
+// Check if instruction is arithmetic. Covers the NativeInteger modmul pipeline:
+// widening products, the ADC/SBB carry chains and the shifts of Barrett reduction.
 bool IsArithmeticInstruction(INS ins) {
     OPCODE opcode = INS_Opcode(ins);
     return (opcode == XED_ICLASS_ADD ||
+            opcode == XED_ICLASS_ADC ||
+            opcode == XED_ICLASS_ADCX ||
+            opcode == XED_ICLASS_ADOX ||
             opcode == XED_ICLASS_SUB ||
+            opcode == XED_ICLASS_SBB ||
             opcode == XED_ICLASS_MUL ||
             opcode == XED_ICLASS_IMUL ||
+            opcode == XED_ICLASS_MULX ||
+            opcode == XED_ICLASS_SHRD ||
+            opcode == XED_ICLASS_SHLD ||
             opcode == XED_ICLASS_ADDSD ||
             opcode == XED_ICLASS_SUBSD ||
             opcode == XED_ICLASS_MULSD ||
@@ -42,60 +115,92 @@ bool IsArithmeticInstruction(INS ins) {
             opcode == XED_ICLASS_MULSS);
 }
 
-// Get the destination register of an instruction
-REG GetDestinationRegister(INS ins) {
-    if (INS_OperandCount(ins) > 0 && INS_OperandIsReg(ins, 0)) {
-        return INS_OperandReg(ins, 0);
-    }
-    return REG_INVALID();
-}
-
-// Flip bit in register
-VOID FlipBitInRegister(CONTEXT *ctx, REG reg, UINT32 bit_pos, ADDRINT ip) {
-    UINT8 reg_value[32];  // 256 bits should be enough for most registers
-
-    if (REG_valid(reg)) {
-        // Get register value
-        PIN_GetContextRegval(ctx, reg, reg_value);
+// Every register the instruction writes, including implicit ones (RDX:RAX of
+// MUL, flags of ADC/SBB). Widening multiplies tag each destination with its half.
+vector<WrittenReg> GetWrittenRegisters(INS ins) {
+    vector<WrittenReg> regs;
+    OPCODE opcode = INS_Opcode(ins);
 
-        // Calculate byte and bit position
-        UINT32 byte_pos = bit_pos / 8;
-        UINT32 bit_in_byte = bit_pos % 8;
+    if (opcode == XED_ICLASS_MULX) {
+        // mulx hi, lo, src
+        REG hi = INS_OperandReg(ins, 0);
+        REG lo = INS_OperandReg(ins, 1);
+        regs.push_back({REG_FullRegName(hi), (UINT32)REG_Size(hi) * 8, HALF_HI});
+        regs.push_back({REG_FullRegName(lo), (UINT32)REG_Size(lo) * 8, HALF_LO});
+        return regs;
+    }
 
-        // Flip the specified bit
-        if (byte_pos < 32) {
-            reg_value[byte_pos] ^= (1 << bit_in_byte);
+    bool widening = (opcode == XED_ICLASS_MUL || opcode == XED_ICLASS_IMUL) &&
+                    (INS_RegWContain(ins, REG_RDX) || INS_RegWContain(ins, REG_EDX));
+
+    for (UINT32 i = 0; i < INS_MaxNumWRegs(ins); ++i) {
+        REG reg = INS_RegW(ins, i);
+        if (!REG_valid(reg) || reg == REG_INST_PTR || REG_is_seg(reg))
+            continue;
+        ProductHalf half = HALF_ANY;
+        if (widening) {
+            REG full = REG_FullRegName(reg);
+            if (full == REG_RAX) half = HALF_LO;
+            if (full == REG_RDX) half = HALF_HI;
         }
-
-        // Set register value back
-        PIN_SetContextRegval(ctx, reg, reg_value);
-
-        logfile << "FAULT INJECTED: Function=" << target_function
-                << " ArithOp=" << arith_ops_in_function
-                << " Bit=" << bit_pos
-                << " Register=" << REG_StringShort(reg)
-                << " IP=0x" << hex << ip << dec << endl;
-        logfile.flush();
-
-        fault_injected = true;
+        regs.push_back({REG_FullRegName(reg), (UINT32)REG_Size(reg) * 8, half});
     }
+    return regs;
 }
 
-// Count arithmetic operations
-VOID CountArithOp() {
-    if (inside_target_function) {
-        arith_ops_in_function++;
+// Pick the register this instruction exposes to the campaign, if any
+bool SelectRegister(INS ins, WrittenReg* out) {
+    const string& wanted = KnobTargetReg.Value();
+    for (const WrittenReg& w : GetWrittenRegisters(ins)) {
+        if (target_half != HALF_ANY && w.half != target_half)
+            continue;
+        if (wanted == "dest") {
+            if (w.reg == REG_RFLAGS || REG_is_flags(w.reg))
+                continue;
+        } else if (REG_StringShort(w.reg) != wanted) {
+            continue;
+        }
+        *out = w;
+        return true;
     }
+    return false;
 }
 
-// Conditional bit flip after instruction execution
-VOID ConditionalBitFlip(CONTEXT *ctx, ADDRINT ip, REG dest_reg) {
-    if (inside_target_function &&
-        arith_ops_in_function == target_arith_op_number &&
-        !fault_injected) {
+// Count arithmetic operations; returns true for the target one
+ADDRINT PIN_FAST_ANALYSIS_CALL CountArithOp() {
+    if (!inside_target_function || !armed) return 0;
+    arith_ops_in_function++;
+    return arith_ops_in_function == target_arith_op_number + 1 && !fault_injected;
+}
 
-        FlipBitInRegister(ctx, dest_reg, target_bit, ip);
-    }
+VOID MarkFaultPending() {
+    fault_pending = 1;
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsFaultPending() {
+    return fault_pending;
+}
+
+// Fault in register, written back by Pin through IARG_REG_REFERENCE
+VOID FlipBitInRegister(ADDRINT ip, PIN_REGISTER* value, UINT32 reg, UINT32 bits, UINT32 half) {
+    fault_pending = 0;
+    UINT32 bit_pos = target_bit % bits;
+    UINT64 mask = faultmodel::xorValue(fault_model, value->byte, (bits + 7) / 8, bit_pos);
+
+    PLOG_INFO("FAULT INJECTED: Function=" << target_function
+              << " ArithOp=" << arith_ops_in_function - 1
+              << " Bit=" << bit_pos
+              << " Model=" << faultmodel::name(fault_model)
+              << " Mask=0x" << hex << mask << dec
+              << " Register=" << REG_StringShort((REG)reg)
+              << " Half=" << HalfName(half)
+              << " IP=0x" << hex << ip << dec);
+
+    SiteStats& site = sites[ip];
+    site.reg = REG_StringShort((REG)reg);
+    site.half = half;
+    last_site_ip = ip;
+    fault_injected = true;
 }
 
 // Function entry callback
@@ -103,10 +208,6 @@ VOID EnterTargetFunction(ADDRINT func_addr) {
     if (!inside_target_function) {  // Avoid nested calls
         inside_target_function = true;
         arith_ops_in_function = 0;
-        fault_injected = false;
-
-        logfile << "ENTER: " << target_function << " at 0x" << hex << func_addr << dec << endl;
-        logfile.flush();
     }
 }
 
@@ -114,54 +215,88 @@ VOID EnterTargetFunction(ADDRINT func_addr) {
 VOID ExitTargetFunction(ADDRINT func_addr) {
     if (inside_target_function) {
         inside_target_function = false;
+    }
+}
+
+VOID OnLabelHit() {
+    armed = 1;
+    PLOG_INFO("ARMED: target op " << target_arith_op_number << " bit " << target_bit);
+}
+
+// The app reports the norm of the iteration that just finished
+VOID OnReportNorm(ADDRINT norm_ptr) {
+    double norm = 0;
+    if (PIN_SafeCopy(&norm, reinterpret_cast<VOID*>(norm_ptr), sizeof(norm)) != sizeof(norm))
+        return;
+    if (!fault_injected) {
+        PLOG_INFO("NOT REACHED: op " << target_arith_op_number);
+        return;
+    }
+    SiteStats& site = sites[last_site_ip];
+    site.injections++;
+    if (!std::isfinite(norm)) {
+        site.nonFinite++;
+        return;
+    }
+    if (norm <= KnobMaskedEps.Value())
+        site.masked++;
+    site.sumNorm += norm;
+    if (norm > site.maxNorm)
+        site.maxNorm = norm;
+}
 
-        logfile << "EXIT: " << target_function << " at 0x" << hex << func_addr << dec
-                << " (Total arith ops: " << arith_ops_in_function << ")" << endl;
-        logfile.flush();
+// Next iteration: next bit at the same site, or the next site
+VOID OnSyncMarker() {
+    fault_injected = false;
+    if (++bits_done_at_site < KnobBitsPerSite.Value()) {
+        target_bit += faultmodel::bitStride(fault_model);
+        return;
     }
+    bits_done_at_site = 0;
+    target_bit = KnobTargetBit.Value();
+    target_arith_op_number += KnobOpStep.Value();
 }
 
 // Instruction instrumentation
 VOID Instruction(INS ins, VOID *v) {
-    if (IsArithmeticInstruction(ins)) {
-        // Count arithmetic operations
-        INS_InsertCall(ins, IPOINT_BEFORE,
-                       (AFUNPTR)CountArithOp,
+    if (!IsArithmeticInstruction(ins))
+        return;
+
+    WrittenReg target;
+    if (!SelectRegister(ins, &target))
+        return;
+
+    if (!INS_IsValidForIpointAfter(ins))
+        return;
+
+    // Count before, flip the written value after execution
+    INS_InsertIfCall(ins, IPOINT_BEFORE, (AFUNPTR)CountArithOp,
+                     IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_BEFORE, (AFUNPTR)MarkFaultPending, IARG_END);
+
+    INS_InsertIfCall(ins, IPOINT_AFTER, (AFUNPTR)IsFaultPending,
+                     IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_AFTER, (AFUNPTR)FlipBitInRegister,
+                       IARG_INST_PTR,
+                       IARG_REG_REFERENCE, target.reg,
+                       IARG_UINT32, target.reg,
+                       IARG_UINT32, target.bits,
+                       IARG_UINT32, target.half,
                        IARG_END);
 
-        // Get destination register
-        REG dest_reg = GetDestinationRegister(ins);
-
-        if (REG_valid(dest_reg)) {
-            // Insert fault injection after instruction execution
-            INS_InsertCall(ins, IPOINT_AFTER,
-                           (AFUNPTR)ConditionalBitFlip,
-                           IARG_CONTEXT,
-                           IARG_INST_PTR,
-                           IARG_UINT32, dest_reg,
-                           IARG_END);
-        }
-    }
+    ADDRINT ip = INS_Address(ins);
+    if (sites.find(ip) == sites.end())
+        sites[ip].mnemonic = INS_Mnemonic(ins);
 }
 
 // Image instrumentation
 VOID Image(IMG img, VOID *v) {
-    // Debug: Log all images being loaded
-    logfile << "DEBUG: Loading image: " << IMG_Name(img) << endl;
-
     if (target_function.empty()) return;
 
-    bool found_function = false;
-
     for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
         for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
             string name = RTN_Name(rtn);
 
-            // Debug: Log some function names to see what's available
-            if (name.find("Encrypt") != string::npos || name.find("encrypt") != string::npos) {
-                logfile << "DEBUG: Found encrypt-related function: " << name << endl;
-            }
-
             if (name == target_function) {
                 RTN_Open(rtn);
 
@@ -176,25 +311,55 @@ VOID Image(IMG img, VOID *v) {
                                IARG_ADDRINT, RTN_Address(rtn),
                                IARG_END);
 
-                logfile << "INSTRUMENTED: Function " << name
-                        << " at 0x" << hex << RTN_Address(rtn) << dec << endl;
-
-                found_function = true;
+                PLOG_INFO("INSTRUMENTED: Function " << name
+                          << " at 0x" << hex << RTN_Address(rtn) << dec);
+                RTN_Close(rtn);
+            }
+            else if (name == KnobLabel.Value()) {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, (AFUNPTR)OnLabelHit, IARG_END);
+                RTN_Close(rtn);
+            }
+            else if (name == "sync_marker") {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, (AFUNPTR)OnSyncMarker, IARG_END);
+                RTN_Close(rtn);
+            }
+            else if (name == "report_norm") {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, (AFUNPTR)OnReportNorm,
+                               IARG_FUNCARG_ENTRYPOINT_VALUE, 0, IARG_END);
                 RTN_Close(rtn);
-                break;
             }
         }
-        if (found_function) break;
+    }
+}
+
+VOID WriteSiteReport() {
+    ofstream report(KnobSiteReport.Value().c_str());
+    report << "ip,mnemonic,reg,half,injections,masked,non_finite,mean_norm,max_norm\n";
+    for (const auto& entry : sites) {
+        const SiteStats& s = entry.second;
+        if (s.injections == 0) continue;
+        UINT64 finite = s.injections - s.nonFinite;
+        report << "0x" << hex << entry.first << dec << ","
+               << s.mnemonic << "," << s.reg << "," << HalfName(s.half) << ","
+               << s.injections << "," << s.masked << "," << s.nonFinite << ","
+               << (finite ? s.sumNorm / finite : 0.0) << "," << s.maxNorm << "\n";
     }
 }
 
 // Cleanup on exit
 VOID Fini(INT32 code, VOID *v) {
-    logfile << "SUMMARY: Target=" << target_function
-            << " TargetOp=" << target_arith_op_number
-            << " TargetBit=" << target_bit
-            << " FaultInjected=" << (fault_injected ? "YES" : "NO") << endl;
-    logfile.close();
+    PLOG_INFO("SUMMARY: Target=" << target_function
+              << " TargetOp=" << target_arith_op_number
+              << " TargetBit=" << target_bit
+              << " TargetHalf=" << HalfName(target_half)
+              << " FaultInjected=" << (fault_injected ? "YES" : "NO"));
+
+    if (!KnobSiteReport.Value().empty())
+        WriteSiteReport();
+    pinlog::Fini();
 }
 
 // Usage information
@@ -204,11 +369,19 @@ INT32 Usage() {
     cerr << "Options:" << endl;
     cerr << "  -target_func <name>     : Target function name" << endl;
     cerr << "  -target_arith <N>       : N-th arithmetic operation (0-based)" << endl;
-    cerr << "  -target_bit <bit>       : Bit position to flip (0-255)" << endl;
+    cerr << "  -target_bit <bit>       : Bit position to flip" << endl;
+    cerr << "  -target_half <lo|hi|any>: Half of the 128-bit product to attack" << endl;
+    cerr << "  -target_reg <dest|name> : Written register to attack (rdx, rflags, ...)" << endl;
     cerr << "  -log <path>             : Log file path" << endl;
+    cerr << "  -label <sym>            : Sweep: stub that arms the injector" << endl;
+    cerr << "  -bits_per_site <n>      : Sweep: bits flipped at each site" << endl;
+    cerr << "  -op_step <n>            : Sweep: ops between sites" << endl;
+    cerr << "  -site_report <path>     : Sweep: per-site vulnerability CSV" << endl;
     cerr << endl;
     cerr << "Example:" << endl;
     cerr << "  pin -t fault_tool.so -target_func Encrypt -target_arith 100 -target_bit 15 -- ./ckks_test" << endl;
+    cerr << "  pin -t fault_tool.so -target_func Decrypt -target_half hi -label addr_label -bits_per_site 64 "
+            "-site_report sites.csv -- ./bitflip_registers 1 1 1000" << endl;
     return -1;
 }
 
@@ -222,6 +395,13 @@ int main(int argc, char *argv[]) {
     target_function = KnobTargetFunc.Value();
     target_arith_op_number = KnobTargetArithOp.Value();
     target_bit = KnobTargetBit.Value();
+    if (!faultmodel::parse(KnobFaultModel.Value(), fault_model)) {
+        cerr << "Error: unknown fault_model " << KnobFaultModel.Value() << endl;
+        return Usage();
+    }
+    if (KnobTargetHalf.Value() == "lo") target_half = HALF_LO;
+    if (KnobTargetHalf.Value() == "hi") target_half = HALF_HI;
+    armed = KnobLabel.Value().empty() ? 1 : 0;
 
     if (target_function.empty()) {
         cerr << "Error: target_func parameter is required" << endl;
@@ -229,21 +409,18 @@ int main(int argc, char *argv[]) {
     }
 
     // Open log file
-    logfile.open(KnobLogFile.Value().c_str());
-    if (!logfile.is_open()) {
+    // Un write por tanda desde un hilo interno en vez de un flush por evento
+    if (!pinlog::Init(KnobLogFile.Value())) {
         cerr << "Error: Cannot open log file " << KnobLogFile.Value() << endl;
         return -1;
     }
 
-    // Force immediate write to ensure file is created
-    logfile << "CKKS Fault Injection Started" << endl;
-    logfile << "Target Function: " << target_function << endl;
-    logfile << "Target Arithmetic Operation: " << target_arith_op_number << endl;
-    logfile << "Target Bit: " << target_bit << endl;
-    logfile << "================================" << endl;
-    logfile.flush();  // Force write to disk
-
-    cerr << "Log file created: " << KnobLogFile.Value() << endl;  // Debug to stderr
+    PLOG_INFO("CKKS Fault Injection Started");
+    PLOG_INFO("Target Function: " << target_function);
+    PLOG_INFO("Target Arithmetic Operation: " << target_arith_op_number);
+    PLOG_INFO("Target Bit: " << target_bit);
+    PLOG_INFO("Target Half: " << HalfName(target_half) << " Register: " << KnobTargetReg.Value());
+    PLOG_INFO("================================");
 
     // Register callbacks
     IMG_AddInstrumentFunction(Image, 0);
@@ -0,0 +1,301 @@
+#include "pin.H"
+#include <cpuid.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "../../src/fault_model.h"
+
+// Lane-aware fault injection on vector registers (XMM/YMM/ZMM and AVX-512
+// opmasks). The fault is expressed as (register width, lane, lane element
+// size, bit) and lands on the destination of the N-th dynamic vector
+// instruction executed inside the target routine. -fault_model shapes it
+// inside the lane element (burst, byte, stuck-at, ...); it never leaves the lane. Each sync_marker re-arms
+// the injector, so one process can run a whole campaign.
+
+// ------------------------------------------------------------------------------------------------
+// Knobs
+// ------------------------------------------------------------------------------------------------
+static KNOB<std::string> KnobTargetFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "func", "",
+    "Routine to attack (mangled name); empty attacks every routine");
+
+static KNOB<UINT64> KnobVecIndex(
+    KNOB_MODE_WRITEONCE, "pintool", "vec_index", "0",
+    "N-th dynamic vector instruction inside the routine (0-based)");
+
+static KNOB<UINT64> KnobVecStep(
+    KNOB_MODE_WRITEONCE, "pintool", "vec_step", "1",
+    "Vector instructions skipped at every sync_marker");
+
+static KNOB<UINT32> KnobWidth(
+    KNOB_MODE_WRITEONCE, "pintool", "width", "256",
+    "Destination register width to attack: 128 (xmm), 256 (ymm), 512 (zmm)");
+
+static KNOB<UINT32> KnobLane(
+    KNOB_MODE_WRITEONCE, "pintool", "lane", "0",
+    "Lane inside the register");
+
+static KNOB<UINT32> KnobElemSize(
+    KNOB_MODE_WRITEONCE, "pintool", "elem_size", "64",
+    "Lane element size in bits (8, 16, 32, 64)");
+
+static KNOB<UINT32> KnobTargetBit(
+    KNOB_MODE_WRITEONCE, "pintool", "bit", "0",
+    "Bit inside the lane element");
+
+static KNOB<std::string> KnobFaultModel(
+    KNOB_MODE_WRITEONCE, "pintool", "fault_model", "bit",
+    "Fault model (src/fault_model.h) inside the lane element; multi:w is one bit here");
+
+static KNOB<BOOL> KnobOpmask(
+    KNOB_MODE_WRITEONCE, "pintool", "opmask", "0",
+    "Attack opmask (k0-k7) destinations instead of vector registers");
+
+static KNOB<std::string> KnobLabel(
+    KNOB_MODE_WRITEONCE, "pintool", "label", "",
+    "Stub that arms the injector (empty: armed from the start)");
+
+static KNOB<BOOL> KnobVerbose(
+    KNOB_MODE_WRITEONCE, "pintool", "verbose", "0",
+    "Log every injection");
+
+// ------------------------------------------------------------------------------------------------
+// Globals
+// ------------------------------------------------------------------------------------------------
+static UINT32  regWidth       = 256;
+static BOOL    useOpmask      = FALSE;
+static UINT32  laneByte       = 0;       // first byte of the lane element
+static UINT32  laneBytes      = 8;
+static UINT32  flipBit        = 0;       // absolute bit inside the register
+static faultmodel::Model faultModel;
+
+static ADDRINT armed          = 1;
+static ADDRINT insideTarget   = 0;
+static UINT32  activeDepth    = 0;
+static UINT64  vecCount       = 0;
+static UINT64  targetVec      = 0;      // vecCount value that fires, 0 once fired
+static UINT64  iterTarget     = 0;      // target of the current iteration (vec_index + 1 + k*vec_step)
+static ADDRINT faultPending   = 0;
+static UINT64  injections     = 0;
+
+#define VLOG(msg) \
+    do { if (KnobVerbose.Value()) std::cerr << msg << std::endl; } while (0)
+
+// ------------------------------------------------------------------------------------------------
+// CPU features
+// ------------------------------------------------------------------------------------------------
+static UINT64 ReadXcr0() {
+    UINT32 eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<UINT64>(edx) << 32) | eax;
+}
+
+// AVX512F in CPUID and ZMM/opmask state enabled by the OS in XCR0
+static bool CpuHasAvx512() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE))
+        return false;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX512F))
+        return false;
+    const UINT64 zmmState = (1ULL << 5) | (1ULL << 6) | (1ULL << 7);
+    return (ReadXcr0() & zmmState) == zmmState;
+}
+
+static bool CpuHasAvx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE))
+        return false;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2))
+        return false;
+    return (ReadXcr0() & 0x6) == 0x6;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Register selection
+// ------------------------------------------------------------------------------------------------
+static UINT32 VectorWidth(REG reg) {
+    if (REG_is_zmm(reg)) return 512;
+    if (REG_is_ymm(reg)) return 256;
+    if (REG_is_xmm(reg)) return 128;
+    return 0;
+}
+
+// First written register that matches the configured fault (width or opmask)
+static REG TargetRegister(INS ins) {
+    for (UINT32 i = 0; i < INS_MaxNumWRegs(ins); ++i) {
+        REG reg = INS_RegW(ins, i);
+        if (useOpmask) {
+            if (REG_is_k_mask(reg)) return reg;
+        } else if (VectorWidth(reg) == regWidth) {
+            return reg;
+        }
+    }
+    return REG_INVALID();
+}
+
+// ------------------------------------------------------------------------------------------------
+// Analysis
+// ------------------------------------------------------------------------------------------------
+ADDRINT PIN_FAST_ANALYSIS_CALL CountVector() {
+    vecCount += insideTarget & armed;
+    return insideTarget & armed & (vecCount == targetVec);
+}
+
+VOID MarkPending() {
+    faultPending = 1;
+}
+
+ADDRINT PIN_FAST_ANALYSIS_CALL IsPending() {
+    return faultPending;
+}
+
+VOID FlipLane(ADDRINT ip, PIN_REGISTER* value, UINT32 reg) {
+    faultPending = 0;
+    targetVec = 0;              // one fault per iteration
+    UINT64 mask = faultmodel::xorValue(faultModel, value->byte + laneByte, laneBytes, KnobTargetBit.Value());
+    ++injections;
+    VLOG("[INFO] Flip " << REG_StringShort((REG)reg) << " lane " << KnobLane.Value()
+         << " bit " << flipBit << " model " << faultmodel::name(faultModel)
+         << " mask 0x" << std::hex << mask << std::dec << " vec " << vecCount - 1
+         << " at 0x" << std::hex << ip << std::dec);
+}
+
+VOID EnterTarget() {
+    if (activeDepth++ == 0) vecCount = 0;
+    insideTarget = 1;
+}
+
+VOID ExitTarget() {
+    if (activeDepth > 0) --activeDepth;
+    insideTarget = activeDepth > 0 ? 1 : 0;
+}
+
+VOID OnLabelHit() {
+    armed = 1;
+    vecCount = 0;
+}
+
+VOID OnSyncMarker() {
+    iterTarget += KnobVecStep.Value();
+    targetVec = iterTarget;
+    vecCount = 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Instrumentation
+// ------------------------------------------------------------------------------------------------
+VOID Instruction(INS ins, VOID*) {
+    REG reg = TargetRegister(ins);
+    if (!REG_valid(reg) || !INS_IsValidForIpointAfter(ins))
+        return;
+
+    INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(CountVector), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_BEFORE, AFUNPTR(MarkPending), IARG_END);
+
+    INS_InsertIfCall(ins, IPOINT_AFTER, AFUNPTR(IsPending), IARG_FAST_ANALYSIS_CALL, IARG_END);
+    INS_InsertThenCall(ins, IPOINT_AFTER, AFUNPTR(FlipLane),
+                       IARG_INST_PTR,
+                       IARG_REG_REFERENCE, reg,
+                       IARG_UINT32, reg,
+                       IARG_END);
+}
+
+VOID ImageCallback(IMG img, VOID*) {
+    for (SEC sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
+        for (RTN rtn = SEC_RtnHead(sec); RTN_Valid(rtn); rtn = RTN_Next(rtn)) {
+            std::string name = RTN_Name(rtn);
+
+            if (!KnobTargetFunc.Value().empty() && name == KnobTargetFunc.Value()) {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(EnterTarget), IARG_END);
+                RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(ExitTarget), IARG_END);
+                RTN_Close(rtn);
+                VLOG("[DBG] Instrumented target " << name);
+            }
+            else if (name == KnobLabel.Value()) {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnLabelHit), IARG_END);
+                RTN_Close(rtn);
+            }
+            else if (name == "sync_marker") {
+                RTN_Open(rtn);
+                RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnSyncMarker), IARG_END);
+                RTN_Close(rtn);
+            }
+        }
+    }
+}
+
+VOID Fini(INT32, VOID*) {
+    std::cerr << "[INFO] " << injections << " injections, width=" << (useOpmask ? 64 : regWidth)
+              << (useOpmask ? " (opmask)" : "") << " lane=" << KnobLane.Value()
+              << " elem=" << KnobElemSize.Value() << " bit=" << KnobTargetBit.Value() << std::endl;
+    if (injections == 0) std::cerr << "[WARNING] No bit flipped" << std::endl;
+}
+
+// Degrade ZMM/opmask faults to YMM when the CPU (or the OS) lacks AVX-512
+static bool ResolveFaultGeometry() {
+    regWidth  = KnobWidth.Value();
+    useOpmask = KnobOpmask.Value();
+
+    if ((regWidth == 512 || useOpmask) && !CpuHasAvx512()) {
+        std::cerr << "[WARNING] AVX-512 not available, degrading to 256-bit YMM faults" << std::endl;
+        regWidth  = 256;
+        useOpmask = FALSE;
+    }
+    if (regWidth == 256 && !CpuHasAvx2()) {
+        std::cerr << "[WARNING] AVX2 not available, degrading to 128-bit XMM faults" << std::endl;
+        regWidth = 128;
+    }
+    if (regWidth != 128 && regWidth != 256 && regWidth != 512) {
+        std::cerr << "[ERROR] width must be 128, 256 or 512" << std::endl;
+        return false;
+    }
+
+    UINT32 elem  = KnobElemSize.Value();
+    UINT32 total = useOpmask ? 64 : regWidth;
+    if (elem != 8 && elem != 16 && elem != 32 && elem != 64) {
+        std::cerr << "[ERROR] elem_size must be 8, 16, 32 or 64" << std::endl;
+        return false;
+    }
+    if (KnobTargetBit.Value() >= elem) {
+        std::cerr << "[ERROR] bit must be smaller than elem_size" << std::endl;
+        return false;
+    }
+    flipBit = KnobLane.Value() * elem + KnobTargetBit.Value();
+    if (flipBit >= total) {
+        std::cerr << "[ERROR] lane " << KnobLane.Value() << " does not exist in a "
+                  << total << "-bit register with " << elem << "-bit elements" << std::endl;
+        return false;
+    }
+    laneBytes = elem / 8;
+    laneByte  = KnobLane.Value() * laneBytes;
+    if (!faultmodel::parse(KnobFaultModel.Value(), faultModel)) {
+        std::cerr << "[ERROR] unknown fault_model " << KnobFaultModel.Value() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+INT32 Usage() {
+    std::cerr << "Lane-aware SIMD fault injection Pin tool" << std::endl;
+    std::cerr << KNOB_BASE::StringKnobSummary() << std::endl;
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    PIN_InitSymbols();
+    if (PIN_Init(argc, argv)) return Usage();
+    if (!ResolveFaultGeometry()) return Usage();
+
+    iterTarget   = KnobVecIndex.Value() + 1;
+    targetVec    = iterTarget;
+    armed        = KnobLabel.Value().empty() ? 1 : 0;
+    insideTarget = KnobTargetFunc.Value().empty() ? 1 : 0;
+
+    IMG_AddInstrumentFunction(ImageCallback, nullptr);
+    INS_AddInstrumentFunction(Instruction, nullptr);
+    PIN_AddFiniFunction(Fini, nullptr);
+    PIN_StartProgram();
+    return 0;
+}
@@ -43,7 +43,19 @@ def infer_separator(path: str) -> str:
         print(f"[ERROR] No se pudo leer {path}: {e}")
         sys.exit(1)
 
-def load_and_validate_csv(csv_path: str) -> pd.DataFrame:
+def resolve_symbol_ids(df: pd.DataFrame, symbols_path: str) -> pd.DataFrame:
+    """Pasa las columnas *_Id de openfhe_counter a nombres con la tabla de simbolos"""
+    if not os.path.exists(symbols_path):
+        print(f"[ERROR] Tabla de simbolos {symbols_path} no encontrada")
+        sys.exit(1)
+    symbols = pd.read_csv(symbols_path, sep='\t', keep_default_na=False, quoting=3)
+    names = dict(zip(symbols['Id'].astype(int), symbols['Nombre']))
+    for col in [c for c in df.columns if c.endswith('_Id')]:
+        df[col[:-3]] = df[col].map(lambda v: names.get(int(v), "") if pd.notna(v) else "")
+        df = df.drop(columns=[col])
+    return df
+
+def load_and_validate_csv(csv_path: str, symbols_path: Optional[str] = None) -> pd.DataFrame:
     """Carga y valida el CSV de OpenFHE"""
     if not os.path.exists(csv_path):
         print(f"[ERROR] Archivo {csv_path} no encontrado")
@@ -60,6 +72,11 @@ def load_and_validate_csv(csv_path: str) -> pd.DataFrame:
         # Limpiar nombres de columnas (remover espacios y caracteres raros)
         df.columns = df.columns.str.strip()
 
+        if 'Funcion_Actual_Id' in df.columns:
+            if symbols_path is None:
+                symbols_path = os.path.join(os.path.dirname(csv_path), 'openfhe_ckks_symbols.tsv')
+            df = resolve_symbol_ids(df, symbols_path)
+
         print(f"[INFO] Cargadas {len(df)} filas")
         print(f"[INFO] Columnas disponibles: {list(df.columns)}")
 
@@ -381,6 +398,8 @@ Ejemplos de uso:
     parser.add_argument('--child_father', type=int, choices=[0, 1], default=1,
                     help='1 = mostrar todos los padres (default), 0 = solo primer y último padre')
 
+    parser.add_argument('--symbols', default=None,
+                       help='Tabla de simbolos de openfhe_counter (default: openfhe_ckks_symbols.tsv al lado del CSV)')
     parser.add_argument('--no-heatmap', action='store_true',
                        help='Omitir generación de heatmap')
     parser.add_argument('--heatmap-functions', type=int, default=10,
@@ -398,7 +417,7 @@ Ejemplos de uso:
     print(f"Hijos mostrados: {args.child_father}")
 
     # Cargar datos
-    df = load_and_validate_csv(args.csv_file)
+    df = load_and_validate_csv(args.csv_file, args.symbols)
 
     # Generar análisis
     plot_instruction_categories(df, args.output_prefix)
@@ -0,0 +1,561 @@
+// cache_sim.cpp
+// Simulacion de cache para las referencias a memoria entre start_measurement y
+// end_measurement (mismos marcadores que openfhe_counter).
+//
+// Las instrucciones con acceso a memoria llenan un trace buffer de Pin
+// (PIN_DefineTraceBuffer): el hilo de la aplicacion solo escribe el registro,
+// sin locks ni llamadas. Cuando el buffer se llena, Pin llama a BufferFull,
+// que lo encola y devuelve uno libre; un hilo interno de la tool pasa los
+// registros por el modelo de cache. Asi la simulacion corre en paralelo con la
+// aplicacion y la memoria queda acotada por -buffers.
+//
+// Modelo: niveles set-asociativos con LRU, write-allocate, no inclusivos. Un
+// miss en un nivel pasa al siguiente. Con -prefetch 1 cada miss trae ademas la
+// linea siguiente a ese nivel.
+//
+// Reporta misses por nivel, por rutina (la que contiene la instruccion) y por
+// limb: cada llamada de mas afuera a una rutina -limb_func dentro de una de
+// -poly_func es la iteracion siguiente del loop sobre los limbs (DCRTPoly
+// recorre sus towers llamando a los metodos de PolyImpl de cada una). Solo
+// cuentan las operaciones por tower: constructores, destructores, operator=,
+// operator[], at y los Get* de PolyImpl no abren un limb (los copia o los
+// consulta DCRTPoly fuera del loop, o varias veces por tower), y fuera de
+// -poly_func tampoco.
+#include "pin.H"
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::map;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// -----------------------------------------------------------------
+// Configuración
+// -----------------------------------------------------------------
+static const string START_MARKER = "start_measurement";
+static const string END_MARKER   = "end_measurement";
+
+static KNOB<string> KnobOutput(
+    KNOB_MODE_WRITEONCE, "pintool", "o", "cache_sim",
+    "Prefijo de los CSV: _levels, _routines y _limbs");
+static KNOB<string> KnobCaches(
+    KNOB_MODE_WRITEONCE, "pintool", "caches", "32K:8,1M:16,32M:16",
+    "Niveles tamaño:vias separados por coma, de L1 hacia afuera");
+static KNOB<UINT32> KnobLine(
+    KNOB_MODE_WRITEONCE, "pintool", "line", "64",
+    "Tamaño de linea en bytes (potencia de 2)");
+static KNOB<BOOL> KnobPrefetch(
+    KNOB_MODE_WRITEONCE, "pintool", "prefetch", "0",
+    "Prefetch de la linea siguiente en cada miss");
+static KNOB<string> KnobPolyFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "poly_func", "DCRTPolyImpl<",
+    "Subcadena de las rutinas que recorren los limbs");
+static KNOB<string> KnobLimbFunc(
+    KNOB_MODE_WRITEONCE, "pintool", "limb_func", "PolyImpl<intnat::NativeVector",
+    "Subcadena de las rutinas que procesan un limb");
+static KNOB<UINT32> KnobBufferPages(
+    KNOB_MODE_WRITEONCE, "pintool", "buffer_pages", "256",
+    "Paginas de cada trace buffer");
+static KNOB<UINT32> KnobBuffers(
+    KNOB_MODE_WRITEONCE, "pintool", "buffers", "8",
+    "Buffers en vuelo entre la aplicacion y el simulador");
+static KNOB<UINT32> KnobTop(
+    KNOB_MODE_WRITEONCE, "pintool", "top", "50",
+    "Rutinas en el CSV (por misses del ultimo nivel)");
+
+// -----------------------------------------------------------------
+// Registro del trace buffer
+// -----------------------------------------------------------------
+struct MemRef {
+    ADDRINT ea;
+    ADDRINT limb;   // 0 fuera de un limb, si no indice + 1 (registro de la tool)
+    UINT32 size;
+    UINT32 rtn;     // indice en routines, 0 = UNKNOWN
+};
+
+static BUFFER_ID buffer_id;
+static REG limb_reg;
+
+// -----------------------------------------------------------------
+// Modelo de cache
+// -----------------------------------------------------------------
+class CacheLevel {
+public:
+    CacheLevel(const string& name, UINT64 size, UINT32 ways, UINT32 lineBits)
+        : name_(name), ways_(ways), sets_(std::max<UINT64>(1, size / (static_cast<UINT64>(ways) << lineBits))),
+          tags_(sets_ * ways, EMPTY), size_(size) {}
+
+    // true si estaba; si no la trae y desaloja la LRU del set
+    bool Access(UINT64 line) {
+        UINT64* set = &tags_[(line % sets_) * ways_];
+        for (UINT32 w = 0; w < ways_; ++w) {
+            if (set[w] != line)
+                continue;
+            std::rotate(set, set + w, set + w + 1);   // a MRU
+            return true;
+        }
+        std::rotate(set, set + ways_ - 1, set + ways_);
+        set[0] = line;
+        return false;
+    }
+
+    const string& Name() const { return name_; }
+    UINT64 Size() const { return size_; }
+    UINT32 Ways() const { return ways_; }
+
+    UINT64 accesses = 0;
+    UINT64 misses = 0;
+    UINT64 prefetches = 0;
+
+private:
+    static const UINT64 EMPTY = ~0ULL;
+    string name_;
+    UINT32 ways_;
+    UINT64 sets_;
+    vector<UINT64> tags_;   // por set, de MRU a LRU
+    UINT64 size_;
+};
+
+static vector<CacheLevel> levels;
+static UINT32 line_bits = 6;
+
+// Conteos por rutina y por limb: [0] accesos, [1 + i] misses del nivel i
+static vector<string> routines(1, "UNKNOWN");
+static map<string, UINT32> routine_ids;
+static vector<vector<UINT64> > per_routine;
+static vector<vector<UINT64> > per_limb;   // [0] fuera de los limbs
+
+static vector<UINT64>& Row(vector<vector<UINT64> >& table, size_t i) {
+    if (table.size() <= i)
+        table.resize(i + 1, vector<UINT64>(levels.size() + 1, 0));
+    return table[i];
+}
+
+static VOID Simulate(const MemRef* refs, UINT64 count) {
+    for (UINT64 r = 0; r < count; ++r) {
+        const MemRef& ref = refs[r];
+        vector<UINT64>& rtn = Row(per_routine, ref.rtn);
+        vector<UINT64>& limb = Row(per_limb, ref.limb);
+        UINT64 first = ref.ea >> line_bits;
+        UINT64 last = (ref.ea + std::max<UINT32>(ref.size, 1) - 1) >> line_bits;
+        for (UINT64 line = first; line <= last; ++line) {
+            ++rtn[0];
+            ++limb[0];
+            for (size_t l = 0; l < levels.size(); ++l) {
+                CacheLevel& level = levels[l];
+                ++level.accesses;
+                if (level.Access(line))
+                    break;
+                ++level.misses;
+                ++rtn[1 + l];
+                ++limb[1 + l];
+                if (KnobPrefetch.Value() && !level.Access(line + 1))
+                    ++level.prefetches;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------
+// Cola de buffers llenos y el hilo simulador
+// -----------------------------------------------------------------
+struct FullBuffer {
+    VOID* buf;
+    UINT64 count;
+};
+
+static PIN_LOCK queue_lock;
+static PIN_SEMAPHORE queue_ready;
+static std::deque<FullBuffer> full_buffers;
+static vector<VOID*> free_buffers;
+static UINT32 allocated_buffers = 0;
+static volatile BOOL stopping = FALSE;
+static PIN_THREAD_UID simulator_uid;
+static BOOL simulator_running = FALSE;
+static UINT64 simulated_refs = 0;
+
+static BOOL PopFull(FullBuffer* out) {
+    PIN_GetLock(&queue_lock, PIN_ThreadId() + 1);
+    BOOL found = !full_buffers.empty();
+    if (found) {
+        *out = full_buffers.front();
+        full_buffers.pop_front();
+    }
+    PIN_ReleaseLock(&queue_lock);
+    return found;
+}
+
+static VOID Recycle(VOID* buf) {
+    PIN_GetLock(&queue_lock, PIN_ThreadId() + 1);
+    free_buffers.push_back(buf);
+    PIN_ReleaseLock(&queue_lock);
+}
+
+static VOID SimulateQueued() {
+    FullBuffer full;
+    while (PopFull(&full)) {
+        Simulate(static_cast<const MemRef*>(full.buf), full.count);
+        simulated_refs += full.count;
+        Recycle(full.buf);
+    }
+}
+
+static VOID SimulatorThread(VOID*) {
+    while (!stopping) {
+        PIN_SemaphoreTimedWait(&queue_ready, 10);
+        PIN_SemaphoreClear(&queue_ready);
+        SimulateQueued();
+    }
+    SimulateQueued();
+    PIN_ExitThread(0);
+}
+
+// Lo llama Pin en el hilo de la aplicacion con el buffer lleno (o al terminar el hilo)
+static VOID* BufferFull(BUFFER_ID id, THREADID tid, const CONTEXT* ctxt, VOID* buf, UINT64 numElements, VOID* v) {
+    if (numElements == 0)
+        return buf;
+    VOID* next = nullptr;
+    PIN_GetLock(&queue_lock, tid + 1);
+    full_buffers.push_back(FullBuffer{buf, numElements});
+    // Sin simulador los buffers se acumulan hasta Fini
+    if (free_buffers.empty() && (allocated_buffers < KnobBuffers.Value() || !simulator_running)) {
+        ++allocated_buffers;
+        next = PIN_AllocateBuffer(id);
+    }
+    PIN_ReleaseLock(&queue_lock);
+    PIN_SemaphoreSet(&queue_ready);
+
+    // Todos los buffers en vuelo: esperar a que el simulador libere uno
+    while (!next) {
+        PIN_GetLock(&queue_lock, tid + 1);
+        if (!free_buffers.empty()) {
+            next = free_buffers.back();
+            free_buffers.pop_back();
+        }
+        PIN_ReleaseLock(&queue_lock);
+        if (!next)
+            PIN_Yield();
+    }
+    return next;
+}
+
+static VOID PrepareForFini(VOID*) {
+    stopping = TRUE;
+    PIN_SemaphoreSet(&queue_ready);
+    if (simulator_running) {
+        PIN_WaitForThreadTermination(simulator_uid, PIN_INFINITE_TIMEOUT, nullptr);
+        simulator_running = FALSE;
+    }
+}
+
+// -----------------------------------------------------------------
+// Ventana de medicion y limbs (solo el hilo principal, como openfhe_counter)
+// -----------------------------------------------------------------
+static volatile BOOL measuring = FALSE;
+static BOOL measurement_ended = FALSE;
+static THREADID main_tid = INVALID_THREADID;
+static UINT32 poly_depth = 0;
+static UINT32 limb_depth = 0;
+static ADDRINT next_limb = 0;
+
+static ADDRINT IsRecording(THREADID tid) {
+    return measuring && tid == main_tid;
+}
+
+VOID OnStartMeasurement(THREADID tid) {
+    if (measurement_ended) return;
+    main_tid = tid;
+    measuring = TRUE;
+    cout << "[PIN] *** INICIO DE MEDICIÓN *** (Hilo: " << tid << ")" << endl;
+}
+
+VOID OnEndMeasurement(THREADID tid) {
+    if (tid != main_tid) return;
+    measuring = FALSE;
+    measurement_ended = TRUE;
+    cout << "[PIN] *** FIN DE MEDICIÓN *** (Hilo: " << tid << ")" << endl;
+}
+
+VOID OnPolyEntry(THREADID tid) {
+    if (!measuring || tid != main_tid) return;
+    if (poly_depth++ == 0)
+        next_limb = 0;
+}
+
+VOID OnPolyExit(THREADID tid) {
+    if (!measuring || tid != main_tid || poly_depth == 0) return;
+    --poly_depth;
+}
+
+ADDRINT OnLimbEntry(THREADID tid, ADDRINT current) {
+    if (!measuring || tid != main_tid || poly_depth == 0) return current;
+    if (limb_depth++ == 0)
+        return ++next_limb;   // indice + 1
+    return current;
+}
+
+ADDRINT OnLimbExit(THREADID tid, ADDRINT current) {
+    if (!measuring || tid != main_tid || poly_depth == 0 || limb_depth == 0) return current;
+    return --limb_depth == 0 ? 0 : current;
+}
+
+// -----------------------------------------------------------------
+// Instrumentación
+// -----------------------------------------------------------------
+static UINT32 RoutineId(RTN rtn) {
+    if (!RTN_Valid(rtn))
+        return 0;
+    string name = PIN_UndecorateSymbolName(RTN_Name(rtn), UNDECORATION_NAME_ONLY);
+    auto it = routine_ids.find(name);
+    if (it != routine_ids.end())
+        return it->second;
+    UINT32 id = static_cast<UINT32>(routines.size());
+    routines.push_back(name);
+    routine_ids[name] = id;
+    return id;
+}
+
+// Metodos de -limb_func que no son el trabajo de un tower: copias, accesos y consultas
+static bool IsTowerOperation(const string& full) {
+    size_t sep = full.rfind("::");
+    if (sep == string::npos)
+        return true;
+    string method = full.substr(sep + 2);
+    string cls = full.substr(0, sep);
+    cls = cls.substr(0, cls.find('<'));
+    size_t clsSep = cls.rfind("::");
+    if (clsSep != string::npos)
+        cls = cls.substr(clsSep + 2);
+    if (method == cls || method[0] == '~')
+        return false;
+    if (method == "operator=" || method == "operator[]" || method == "at")
+        return false;
+    return method.compare(0, 3, "Get") != 0;
+}
+
+VOID InstrumentRoutine(RTN rtn, VOID* v) {
+    string name = RTN_Name(rtn);
+    if (name == START_MARKER || name == END_MARKER) {
+        RTN_Open(rtn);
+        RTN_InsertCall(rtn, IPOINT_BEFORE,
+                       name == START_MARKER ? AFUNPTR(OnStartMeasurement) : AFUNPTR(OnEndMeasurement),
+                       IARG_THREAD_ID, IARG_END);
+        RTN_Close(rtn);
+        return;
+    }
+
+    // Solo el nombre calificado: los parametros pueden mencionar PolyImpl
+    string full = PIN_UndecorateSymbolName(name, UNDECORATION_COMPLETE);
+    full = full.substr(0, full.find('('));
+    bool limb = full.find(KnobLimbFunc.Value()) != string::npos && IsTowerOperation(full);
+    bool poly = full.find(KnobLimbFunc.Value()) == string::npos && full.find(KnobPolyFunc.Value()) != string::npos;
+    if (!limb && !poly)
+        return;
+
+    RTN_Open(rtn);
+    if (poly) {
+        RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnPolyEntry), IARG_THREAD_ID, IARG_END);
+        RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(OnPolyExit), IARG_THREAD_ID, IARG_END);
+    } else {
+        RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnLimbEntry), IARG_THREAD_ID, IARG_REG_VALUE, limb_reg,
+                       IARG_RETURN_REGS, limb_reg, IARG_END);
+        RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(OnLimbExit), IARG_THREAD_ID, IARG_REG_VALUE, limb_reg,
+                       IARG_RETURN_REGS, limb_reg, IARG_END);
+    }
+    RTN_Close(rtn);
+}
+
+VOID InstrumentTrace(TRACE trace, VOID* v) {
+    if (measurement_ended) return;
+
+    RTN rtn = TRACE_Rtn(trace);
+    UINT32 rtn_id = RoutineId(rtn);
+    for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+        for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
+            // Gathers/scatters y similares no tienen un EA por operando
+            if (!INS_IsStandardMemop(ins))
+                continue;
+            UINT32 ops = INS_MemoryOperandCount(ins);
+            for (UINT32 op = 0; op < ops; ++op) {
+                INS_InsertIfCall(ins, IPOINT_BEFORE, AFUNPTR(IsRecording), IARG_THREAD_ID, IARG_END);
+                INS_InsertFillBufferThen(ins, IPOINT_BEFORE, buffer_id,
+                                         IARG_MEMORYOP_EA, op, offsetof(MemRef, ea),
+                                         IARG_REG_VALUE, limb_reg, offsetof(MemRef, limb),
+                                         IARG_UINT32, static_cast<UINT32>(INS_MemoryOperandSize(ins, op)), offsetof(MemRef, size),
+                                         IARG_UINT32, rtn_id, offsetof(MemRef, rtn),
+                                         IARG_END);
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------
+// Reporte
+// -----------------------------------------------------------------
+static string CsvField(const string& s) {
+    if (s.find_first_of(",\"") == string::npos)
+        return s;
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static VOID WriteHeader(ofstream& out, const string& first) {
+    out << first << ",Accesos";
+    for (const CacheLevel& level : levels)
+        out << "," << level.Name() << "_misses";
+    out << "\n";
+}
+
+static VOID WriteRow(ofstream& out, const vector<UINT64>& row) {
+    for (UINT64 v : row)
+        out << "," << v;
+    out << "\n";
+}
+
+VOID Finish(INT32 code, VOID* v) {
+    // Lo que quedo encolado despues de parar el simulador
+    SimulateQueued();
+    cout << "[PIN] Referencias simuladas: " << simulated_refs << endl;
+
+    string prefix = KnobOutput.Value();
+    ofstream levels_file((prefix + "_levels.csv").c_str());
+    ofstream routines_file((prefix + "_routines.csv").c_str());
+    ofstream limbs_file((prefix + "_limbs.csv").c_str());
+    if (!levels_file.is_open() || !routines_file.is_open() || !limbs_file.is_open()) {
+        cerr << "[PIN] ERROR: No se pudieron abrir los CSV " << prefix << "_*.csv" << endl;
+        return;
+    }
+
+    levels_file << "Nivel,Tamaño,Vias,Linea,Accesos,Misses,Miss_rate,Prefetches\n";
+    for (const CacheLevel& level : levels) {
+        double rate = level.accesses ? static_cast<double>(level.misses) / level.accesses : 0;
+        levels_file << level.Name() << "," << level.Size() << "," << level.Ways() << "," << (1u << line_bits) << ","
+                    << level.accesses << "," << level.misses << "," << rate << "," << level.prefetches << "\n";
+        cout << "[PIN] " << level.Name() << ": " << level.accesses << " accesos, " << level.misses << " misses ("
+             << 100.0 * rate << "%)" << endl;
+    }
+
+    // Rutinas ordenadas por misses del ultimo nivel, despues del primero
+    vector<UINT32> order;
+    for (UINT32 i = 0; i < per_routine.size(); ++i)
+        if (per_routine[i][0])
+            order.push_back(i);
+    std::sort(order.begin(), order.end(), [](UINT32 a, UINT32 b) {
+        const vector<UINT64>& ra = per_routine[a];
+        const vector<UINT64>& rb = per_routine[b];
+        return std::lexicographical_compare(rb.rbegin(), rb.rend(), ra.rbegin(), ra.rend());
+    });
+    WriteHeader(routines_file, "Rutina");
+    for (size_t i = 0; i < std::min<size_t>(order.size(), KnobTop.Value()); ++i) {
+        routines_file << CsvField(routines[order[i]]);
+        WriteRow(routines_file, per_routine[order[i]]);
+    }
+
+    // Limb -1: fuera de los loops por limb
+    WriteHeader(limbs_file, "Limb");
+    for (size_t i = 0; i < per_limb.size(); ++i) {
+        limbs_file << static_cast<INT64>(i) - 1;
+        WriteRow(limbs_file, per_limb[i]);
+    }
+    cout << "[PIN] Resultados en " << prefix << "_levels.csv, " << prefix << "_routines.csv y " << prefix
+         << "_limbs.csv" << endl;
+}
+
+// "32K:8,1M:16" -> niveles
+static BOOL ParseCaches(const string& spec) {
+    std::stringstream ss(spec);
+    string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == string::npos)
+            return FALSE;
+        char* end = nullptr;
+        UINT64 size = std::strtoull(item.c_str(), &end, 10);
+        if (*end == 'K' || *end == 'k')
+            size <<= 10;
+        else if (*end == 'M' || *end == 'm')
+            size <<= 20;
+        UINT32 ways = static_cast<UINT32>(std::strtoul(item.c_str() + colon + 1, nullptr, 10));
+        if (size == 0 || ways == 0)
+            return FALSE;
+        levels.push_back(CacheLevel("L" + std::to_string(levels.size() + 1), size, ways, line_bits));
+    }
+    return !levels.empty();
+}
+
+INT32 Usage() {
+    cerr << "Uso: pin -t obj-intel64/cache_sim.so [-caches 32K:8,1M:16,32M:16] [-line 64] [-prefetch 1] "
+            "[-o prefijo] -- <programa_openfhe>" << endl;
+    cerr << KNOB_BASE::StringKnobSummary() << endl;
+    cerr << "El programa debe tener funciones start_measurement() y end_measurement()" << endl;
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    PIN_InitSymbols();
+
+    if (PIN_Init(argc, argv)) {
+        return Usage();
+    }
+
+    UINT32 line = KnobLine.Value();
+    if (line == 0 || (line & (line - 1))) {
+        cerr << "[PIN] ERROR: -line tiene que ser potencia de 2" << endl;
+        return 1;
+    }
+    line_bits = 0;
+    while ((1u << line_bits) < line)
+        ++line_bits;
+    if (!ParseCaches(KnobCaches.Value())) {
+        cerr << "[PIN] ERROR: -caches invalido: " << KnobCaches.Value() << endl;
+        return Usage();
+    }
+
+    limb_reg = PIN_ClaimToolRegister();
+    if (!REG_valid(limb_reg)) {
+        cerr << "[PIN] ERROR: No hay registros de tool libres" << endl;
+        return 1;
+    }
+    buffer_id = PIN_DefineTraceBuffer(sizeof(MemRef), KnobBufferPages.Value(), BufferFull, nullptr);
+    if (buffer_id == BUFFER_ID_INVALID) {
+        cerr << "[PIN] ERROR: No se pudo definir el trace buffer" << endl;
+        return 1;
+    }
+    PIN_InitLock(&queue_lock);
+    PIN_SemaphoreInit(&queue_ready);
+
+    RTN_AddInstrumentFunction(InstrumentRoutine, nullptr);
+    TRACE_AddInstrumentFunction(InstrumentTrace, nullptr);
+    PIN_AddPrepareForFiniFunction(PrepareForFini, nullptr);
+    PIN_AddFiniFunction(Finish, nullptr);
+
+    if (PIN_SpawnInternalThread(SimulatorThread, nullptr, 0, &simulator_uid) == INVALID_THREADID) {
+        cerr << "[PIN] WARN: sin hilo simulador, se simula en Fini" << endl;
+    } else {
+        simulator_running = TRUE;
+    }
+
+    cout << "[PIN] Cache sim iniciado: " << KnobCaches.Value() << ", linea " << line
+         << (KnobPrefetch.Value() ? ", prefetch" : "") << endl;
+    cout << "[PIN] Esperando marcadores start_measurement/end_measurement..." << endl;
+
+    PIN_StartProgram();
+
+    return 0;
+}
@@ -0,0 +1,569 @@
+// counter_analyzer.cpp
+// Reemplazo en C++ de analyze_histograms.py + demangle_objdump.py para el CSV de
+// openfhe_counter. Mapea el archivo con mmap, agrega por nivel de jerarquia y
+// categoria, y demanglea cada simbolo una sola vez con abi::__cxa_demangle.
+//
+// Uso: counter_analyzer [opciones] openfhe_ckks_counts.csv [otro.csv ...]
+//   -l N        nivel de jerarquia (0=actual, 1=+padre1, ...)      (default 0)
+//   -t N        top N funciones                                     (default 15)
+//   -o PREFIX   prefijo de los archivos de salida                   (default openfhe)
+//   -c CAT      solo la categoria CAT (ej. INT_MUL), se puede repetir
+//   -f 0|1      1 = todos los padres, 0 = solo el primero y el ultimo (default 1)
+//   -m N        funciones en la matriz funcion x categoria          (default 10)
+//   -d FILE     cache de demangle persistente (mangled\tdemangled)
+//   -s          nombres largos (>200) como Base(...), como demangle_objdump.py
+//   -y FILE     tabla de simbolos para los CSV con columnas _Id
+//               (default: openfhe_ckks_symbols.tsv al lado del CSV)
+//
+// Escribe PREFIX_categories.txt, PREFIX_top_functions_level_N.txt,
+// PREFIX_matrix_level_N.csv y PREFIX.folded (stacks colapsados para
+// flamegraph.pl / speedscope, una linea "raiz;...;hoja;CATEGORIA conteo").
+// Varios CSV (corridas o hilos distintos) se suman como uno solo.
+
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+static const uint32_t NO_FUNC = UINT32_MAX;
+
+// -----------------------------------------------------------------
+// Archivo mapeado
+// -----------------------------------------------------------------
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            madvise(p, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(p);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    ~MappedFile() {
+        if (data)
+            munmap(const_cast<char*>(data), size);
+    }
+};
+
+// -----------------------------------------------------------------
+// Tabla de simbolos: cada nombre se guarda y se demanglea una vez
+// -----------------------------------------------------------------
+class SymbolTable {
+public:
+    explicit SymbolTable(bool shortNames) : shortNames_(shortNames) {}
+
+    uint32_t intern(string_view name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(raw_.size());
+        raw_.emplace_back(name);
+        pretty_.emplace_back();
+        ids_.emplace(raw_.back(), id);
+        return id;
+    }
+
+    const string& pretty(uint32_t id) {
+        string& p = pretty_[id];
+        if (p.empty())
+            p = clean(demangle(raw_[id]));
+        return p;
+    }
+
+    size_t size() const { return raw_.size(); }
+    size_t demangled() const { return demangled_; }
+
+    bool loadCache(const string& path) {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+        string line;
+        while (std::getline(in, line)) {
+            size_t tab = line.find('\t');
+            if (tab != string::npos)
+                cache_.emplace(line.substr(0, tab), line.substr(tab + 1));
+        }
+        cacheLoaded_ = cache_.size();
+        return true;
+    }
+
+    bool saveCache(const string& path) const {
+        if (cache_.size() == cacheLoaded_)
+            return true;
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        for (const auto& entry : cache_)
+            out << entry.first << '\t' << entry.second << '\n';
+        return static_cast<bool>(out);
+    }
+
+private:
+    struct ViewHash {
+        size_t operator()(string_view s) const { return std::hash<string_view>()(s); }
+    };
+
+    string demangle(const string& mangled) {
+        if (mangled.compare(0, 2, "_Z") != 0)
+            return mangled;
+        auto it = cache_.find(mangled);
+        if (it != cache_.end())
+            return it->second;
+        int status = 0;
+        char* out = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+        string result = (status == 0 && out) ? string(out) : mangled;
+        std::free(out);
+        if (status == 0)
+            ++demangled_;
+        cache_.emplace(mangled, result);
+        return result;
+    }
+
+    string clean(const string& name) const {
+        if (!shortNames_ || name.size() <= 200)
+            return name;
+        string base = name.substr(0, name.find('('));
+        size_t colon = base.rfind("::");
+        if (colon != string::npos)
+            base = base.substr(colon + 2);
+        return base + "(...)";
+    }
+
+    bool shortNames_;
+    std::deque<string> raw_;   // las claves de ids_ apuntan aca, deque no las mueve
+    vector<string> pretty_;
+    std::unordered_map<string_view, uint32_t, ViewHash> ids_;
+    std::unordered_map<string, string> cache_;
+    size_t cacheLoaded_ = 0;
+    size_t demangled_ = 0;
+};
+
+// -----------------------------------------------------------------
+// Agregacion
+// -----------------------------------------------------------------
+struct PathHash {
+    size_t operator()(const vector<uint32_t>& v) const {
+        size_t h = 1469598103934665603ULL;
+        for (uint32_t x : v)
+            h = (h ^ x) * 1099511628211ULL;
+        return h;
+    }
+};
+
+struct Options {
+    int level = 0;
+    size_t top = 15;
+    size_t matrixTop = 10;
+    bool allParents = true;
+    bool shortNames = false;
+    string prefix = "openfhe";
+    string cachePath;
+    string symbolsPath;
+    std::set<string> categories;
+    vector<string> inputs;
+};
+
+struct Totals {
+    vector<string> categoryNames;
+    std::unordered_map<string, uint32_t> categoryIds;
+    vector<uint64_t> perCategory;
+    // camino (raiz..hoja, ya recortado al nivel) -> conteo por categoria
+    std::unordered_map<vector<uint32_t>, vector<uint64_t>, PathHash> perFunction;
+    // stack completo + categoria al final -> conteo
+    std::unordered_map<vector<uint32_t>, uint64_t, PathHash> folded;
+    uint64_t total = 0;
+    uint64_t rows = 0;
+    uint64_t badRows = 0;
+
+    uint32_t category(string_view name) {
+        auto it = categoryIds.find(string(name));
+        if (it != categoryIds.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(categoryNames.size());
+        categoryNames.emplace_back(name);
+        categoryIds.emplace(categoryNames.back(), id);
+        perCategory.push_back(0);
+        return id;
+    }
+};
+
+static char detectSeparator(string_view header) {
+    size_t commas = std::count(header.begin(), header.end(), ',');
+    size_t tabs = std::count(header.begin(), header.end(), '\t');
+    size_t semicolons = std::count(header.begin(), header.end(), ';');
+    if (tabs > commas && tabs > semicolons)
+        return '\t';
+    if (semicolons > commas)
+        return ';';
+    return ',';
+}
+
+static string_view trim(string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\r'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\r'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// Id<TAB>Nombre<TAB>Simbolo de openfhe_counter -> IDs de la SymbolTable (0 es UNKNOWN)
+static bool loadSymbolIds(const string& path, SymbolTable& symbols, vector<uint32_t>& ids) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "[ERROR] No pude abrir la tabla de simbolos " << path << std::endl;
+        return false;
+    }
+    ids.clear();
+    string line;
+    std::getline(in, line);   // header
+    while (std::getline(in, line)) {
+        size_t tab = line.find('\t');
+        if (tab == string::npos)
+            continue;
+        size_t id = std::strtoul(line.c_str(), nullptr, 10);
+        size_t nameEnd = line.find('\t', tab + 1);
+        string_view name = string_view(line).substr(tab + 1, nameEnd == string::npos ? string::npos : nameEnd - tab - 1);
+        if (ids.size() <= id)
+            ids.resize(id + 1, NO_FUNC);
+        ids[id] = id == 0 ? NO_FUNC : symbols.intern(name);
+    }
+    return true;
+}
+
+// Tipo_Instruccion,Conteo,Funcion_Actual,Funcion_Padre_1..N con nombres, o
+// Tipo_Instruccion,Conteo,Funcion_Actual_Id,... con IDs de la tabla de simbolos
+static bool processFile(const string& path, const Options& opt, SymbolTable& symbols, Totals& totals) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "[ERROR] No pude abrir " << path << std::endl;
+        return false;
+    }
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    if (p == end) {
+        std::cerr << "[WARN] " << path << " esta vacio" << std::endl;
+        return true;
+    }
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    string_view header(p, (eol ? eol : end) - p);
+    char sep = detectSeparator(header);
+    if (header.find("Tipo_Instruccion") == string_view::npos) {
+        std::cerr << "[ERROR] " << path << ": falta el header Tipo_Instruccion,Conteo,Funcion_Actual,..." << std::endl;
+        return false;
+    }
+    p = eol ? eol + 1 : end;
+
+    bool withIds = header.find("Funcion_Actual_Id") != string_view::npos;
+    vector<uint32_t> symbolIds;
+    if (withIds) {
+        string symbolsPath = opt.symbolsPath;
+        if (symbolsPath.empty()) {
+            size_t slash = path.rfind('/');
+            symbolsPath = (slash == string::npos ? string() : path.substr(0, slash + 1)) + "openfhe_ckks_symbols.tsv";
+        }
+        if (!loadSymbolIds(symbolsPath, symbols, symbolIds))
+            return false;
+    }
+
+    vector<string_view> fields;
+    vector<uint32_t> stack;   // hoja primero, como en el CSV
+    vector<uint32_t> key;
+    while (p < end) {
+        eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* lineEnd = eol ? eol : end;
+        string_view line(p, lineEnd - p);
+        p = eol ? eol + 1 : end;
+        if (trim(line).empty())
+            continue;
+
+        fields.clear();
+        size_t start = 0;
+        while (true) {
+            size_t pos = line.find(sep, start);
+            fields.push_back(trim(line.substr(start, pos == string_view::npos ? string_view::npos : pos - start)));
+            if (pos == string_view::npos)
+                break;
+            start = pos + 1;
+        }
+        if (fields.size() < 3) {
+            ++totals.badRows;
+            continue;
+        }
+        char* numEnd = nullptr;
+        string countStr(fields[1]);
+        uint64_t count = std::strtoull(countStr.c_str(), &numEnd, 10);
+        if (numEnd == countStr.c_str() || count == 0) {
+            ++totals.badRows;
+            continue;
+        }
+        if (!opt.categories.empty() && !opt.categories.count(string(fields[0])))
+            continue;
+        uint32_t cat = totals.category(fields[0]);
+
+        stack.clear();
+        for (size_t i = 2; i < fields.size(); ++i) {
+            if (fields[i].empty())
+                break;
+            if (withIds) {
+                size_t id = std::strtoul(string(fields[i]).c_str(), nullptr, 10);
+                stack.push_back(id < symbolIds.size() ? symbolIds[id] : NO_FUNC);
+            }
+            else
+                stack.push_back(fields[i] == "UNKNOWN" ? NO_FUNC : symbols.intern(fields[i]));
+        }
+        if (stack.empty() || stack[0] == NO_FUNC)
+            stack.assign(1, NO_FUNC);
+
+        totals.total += count;
+        totals.perCategory[cat] += count;
+        ++totals.rows;
+
+        // Identificador segun nivel: padres (del mas lejano al mas cercano) y la actual
+        key.clear();
+        size_t depth = std::min(stack.size(), static_cast<size_t>(opt.level) + 1);
+        for (size_t i = depth; i-- > 0;)
+            key.push_back(stack[i]);
+        if (!opt.allParents && key.size() > 3)
+            key.erase(key.begin() + 1, key.end() - 2);
+        vector<uint64_t>& cell = totals.perFunction[key];
+        if (cell.size() <= cat)
+            cell.resize(cat + 1, 0);
+        cell[cat] += count;
+
+        key.assign(stack.rbegin(), stack.rend());
+        key.push_back(cat);
+        totals.folded[key] += count;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------
+// Salidas
+// -----------------------------------------------------------------
+static string functionId(const vector<uint32_t>& path, SymbolTable& symbols) {
+    if (path.size() == 1 && path[0] == NO_FUNC)
+        return "UNKNOWN";
+    string id;
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i)
+            id += " -> ";
+        id += path[i] == NO_FUNC ? string("UNKNOWN") : symbols.pretty(path[i]);
+    }
+    return id;
+}
+
+static string csvField(const string& s) {
+    if (s.find_first_of(",\"") == string::npos)
+        return s;
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static double percent(uint64_t v, uint64_t total) {
+    return total ? 100.0 * static_cast<double>(v) / static_cast<double>(total) : 0;
+}
+
+static bool writeOutputs(const Options& opt, SymbolTable& symbols, Totals& totals) {
+    // Categorias
+    vector<uint32_t> cats(totals.categoryNames.size());
+    for (uint32_t i = 0; i < cats.size(); ++i)
+        cats[i] = i;
+    std::sort(cats.begin(), cats.end(),
+              [&](uint32_t a, uint32_t b) { return totals.perCategory[a] > totals.perCategory[b]; });
+    string catPath = opt.prefix + "_categories.txt";
+    std::ofstream catFile(catPath);
+    if (!catFile) {
+        std::cerr << "[ERROR] No pude abrir " << catPath << std::endl;
+        return false;
+    }
+    catFile << std::fixed << std::setprecision(2);
+    for (uint32_t c : cats)
+        catFile << totals.categoryNames[c] << "," << totals.perCategory[c] << ","
+                << percent(totals.perCategory[c], totals.total) << "\n";
+
+    // Funciones ordenadas por total
+    struct Row {
+        const vector<uint32_t>* path;
+        const vector<uint64_t>* counts;
+        uint64_t total;
+    };
+    vector<Row> rows;
+    rows.reserve(totals.perFunction.size());
+    for (const auto& entry : totals.perFunction) {
+        if (entry.first.size() == 1 && entry.first[0] == NO_FUNC)
+            continue;
+        uint64_t sum = 0;
+        for (uint64_t v : entry.second)
+            sum += v;
+        rows.push_back({&entry.first, &entry.second, sum});
+    }
+    size_t keep = std::min(rows.size(), std::max(opt.top, opt.matrixTop));
+    std::partial_sort(rows.begin(), rows.begin() + keep, rows.end(),
+                      [](const Row& a, const Row& b) { return a.total > b.total; });
+
+    string topPath = opt.prefix + "_top_functions_level_" + std::to_string(opt.level) + ".txt";
+    std::ofstream topFile(topPath);
+    if (!topFile) {
+        std::cerr << "[ERROR] No pude abrir " << topPath << std::endl;
+        return false;
+    }
+    topFile << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < std::min(rows.size(), opt.top); ++i)
+        topFile << i + 1 << "," << rows[i].total << "," << percent(rows[i].total, totals.total) << ","
+                << csvField(functionId(*rows[i].path, symbols)) << "\n";
+
+    // Lo que antes era el heatmap: funcion x categoria
+    string matrixPath = opt.prefix + "_matrix_level_" + std::to_string(opt.level) + ".csv";
+    std::ofstream matrixFile(matrixPath);
+    if (!matrixFile) {
+        std::cerr << "[ERROR] No pude abrir " << matrixPath << std::endl;
+        return false;
+    }
+    matrixFile << "Funcion";
+    for (uint32_t c : cats)
+        matrixFile << "," << totals.categoryNames[c];
+    matrixFile << "\n";
+    for (size_t i = 0; i < std::min(rows.size(), opt.matrixTop); ++i) {
+        matrixFile << csvField(functionId(*rows[i].path, symbols));
+        for (uint32_t c : cats)
+            matrixFile << "," << (c < rows[i].counts->size() ? (*rows[i].counts)[c] : 0);
+        matrixFile << "\n";
+    }
+
+    // Stacks colapsados: raiz;...;hoja;CATEGORIA conteo
+    string foldedPath = opt.prefix + ".folded";
+    std::ofstream foldedFile(foldedPath);
+    if (!foldedFile) {
+        std::cerr << "[ERROR] No pude abrir " << foldedPath << std::endl;
+        return false;
+    }
+    string line;
+    for (const auto& entry : totals.folded) {
+        const vector<uint32_t>& key = entry.first;
+        line.clear();
+        for (size_t i = 0; i + 1 < key.size(); ++i) {
+            const string& name = key[i] == NO_FUNC ? string("UNKNOWN") : symbols.pretty(key[i]);
+            line.append(name).push_back(';');
+        }
+        line.append(totals.categoryNames[key.back()]);
+        foldedFile << line << " " << entry.second << "\n";
+    }
+
+    std::cout << "[SUCCESS] Guardado: " << catPath << ", " << topPath << ", " << matrixPath << ", " << foldedPath
+              << std::endl;
+
+    // Resumen como print_summary_stats
+    std::cout << "\n" << string(60, '=') << "\nRESUMEN ESTADISTICO\n" << string(60, '=') << "\n";
+    std::cout << "Total de instrucciones ejecutadas: " << totals.total << "\n";
+    std::cout << "Tipos unicos de instrucciones: " << totals.categoryNames.size() << "\n";
+    std::cout << "Funciones unicas (nivel " << opt.level << "): " << totals.perFunction.size() << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "\nTop 5 categorias de instrucciones:\n";
+    for (size_t i = 0; i < std::min<size_t>(5, cats.size()); ++i)
+        std::cout << "  " << i + 1 << ". " << totals.categoryNames[cats[i]] << ": " << totals.perCategory[cats[i]]
+                  << " (" << percent(totals.perCategory[cats[i]], totals.total) << "%)\n";
+    std::cout << "\nTop 5 funciones (nivel jerarquia " << opt.level << "):\n";
+    for (size_t i = 0; i < std::min<size_t>(5, rows.size()); ++i) {
+        string name = functionId(*rows[i].path, symbols);
+        if (name.size() > 80)
+            name = name.substr(0, 80) + "...";
+        std::cout << "  " << i + 1 << ". " << name << ": " << rows[i].total << " ("
+                  << percent(rows[i].total, totals.total) << "%)\n";
+    }
+    return true;
+}
+
+static int Usage() {
+    std::cerr << "Uso: counter_analyzer [-l nivel] [-t top] [-o prefijo] [-c categoria] [-f 0|1] [-m n] "
+                 "[-d cache] [-s] [-y simbolos.tsv] archivo.csv [archivo.csv ...]"
+              << std::endl;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    int c;
+    while ((c = getopt(argc, argv, "l:t:o:c:f:m:d:y:sh")) != -1) {
+        switch (c) {
+            case 'l': opt.level = std::max(0, std::atoi(optarg)); break;
+            case 't': opt.top = static_cast<size_t>(std::atol(optarg)); break;
+            case 'o': opt.prefix = optarg; break;
+            case 'c': opt.categories.insert(optarg); break;
+            case 'f': opt.allParents = std::atoi(optarg) != 0; break;
+            case 'm': opt.matrixTop = static_cast<size_t>(std::atol(optarg)); break;
+            case 'd': opt.cachePath = optarg; break;
+            case 's': opt.shortNames = true; break;
+            case 'y': opt.symbolsPath = optarg; break;
+            default: return Usage();
+        }
+    }
+    for (int i = optind; i < argc; ++i)
+        opt.inputs.emplace_back(argv[i]);
+    if (opt.inputs.empty())
+        return Usage();
+
+    SymbolTable symbols(opt.shortNames);
+    if (!opt.cachePath.empty() && !symbols.loadCache(opt.cachePath))
+        std::cerr << "[INFO] Cache de demangle nueva: " << opt.cachePath << std::endl;
+
+    Totals totals;
+    for (const string& path : opt.inputs) {
+        if (!processFile(path, opt, symbols, totals))
+            return 1;
+    }
+    std::cout << "[INFO] Filas: " << totals.rows << ", descartadas: " << totals.badRows
+              << ", simbolos: " << symbols.size() << std::endl;
+    if (totals.rows == 0) {
+        std::cerr << "[ERROR] No quedan datos validos" << std::endl;
+        return 1;
+    }
+    if (!writeOutputs(opt, symbols, totals))
+        return 1;
+    std::cout << "[INFO] Demangled: " << symbols.demangled() << std::endl;
+    if (!opt.cachePath.empty() && !symbols.saveCache(opt.cachePath))
+        std::cerr << "[WARN] No pude guardar la cache " << opt.cachePath << std::endl;
+    return 0;
+}
@@ -6,9 +6,12 @@
 #include <stack>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <iomanip>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include "pprof_writer.h"
 
 using std::cerr;
 using std::cout;
@@ -16,6 +19,7 @@ using std::endl;
 using std::hex;
 using std::dec;
 using std::map;
+using std::pair;
 using std::ofstream;
 using std::stack;
 using std::string;
@@ -28,7 +32,35 @@ using std::set;
 // -----------------------------------------------------------------
 static const string START_MARKER = "start_measurement";
 static const string END_MARKER   = "end_measurement";
-static const int CALL_HIERARCHY_DEPTH = 10;
+static const int CALL_HIERARCHY_DEPTH = 10;   // columnas del CSV; el arbol no tiene limite
+
+static KNOB<string> KnobOutput(
+    KNOB_MODE_WRITEONCE, "pintool", "o", "openfhe_ckks_counts.csv",
+    "CSV de conteos (una fila por categoria y jerarquia, con IDs de simbolo)");
+static KNOB<string> KnobSymbols(
+    KNOB_MODE_WRITEONCE, "pintool", "symbols", "openfhe_ckks_symbols.tsv",
+    "Tabla de simbolos: Id<TAB>Nombre<TAB>Simbolo");
+static KNOB<string> KnobUndecorate(
+    KNOB_MODE_WRITEONCE, "pintool", "undecorate", "complete",
+    "Nombres en la tabla: complete (con parametros), name (solo el nombre) o none (mangled)");
+static KNOB<BOOL> KnobCollapseTemplates(
+    KNOB_MODE_WRITEONCE, "pintool", "collapse_templates", "0",
+    "Reemplazar los argumentos de template por <...>");
+static KNOB<string> KnobFolded(
+    KNOB_MODE_WRITEONCE, "pintool", "folded", "openfhe_ckks.folded",
+    "Stacks colapsados (raiz;...;hoja;CATEGORIA conteo) para flamegraph.pl; vacio lo desactiva");
+static KNOB<string> KnobPprof(
+    KNOB_MODE_WRITEONCE, "pintool", "pprof", "openfhe_ckks.pb",
+    "Perfil pprof con un sample type por categoria; vacio lo desactiva");
+static KNOB<BOOL> KnobHeatmap(
+    KNOB_MODE_WRITEONCE, "pintool", "heatmap", "0",
+    "Contar ejecuciones por BBL y resolverlas a archivo:linea (necesita -g)");
+static KNOB<string> KnobHeatmapPrefix(
+    KNOB_MODE_WRITEONCE, "pintool", "heatmap_prefix", "openfhe_heat",
+    "Prefijo de los archivos del heatmap");
+static KNOB<UINT32> KnobHeatmapTop(
+    KNOB_MODE_WRITEONCE, "pintool", "heatmap_top", "20",
+    "Lineas calientes por categoria");
 
 // -----------------------------------------------------------------
 // Estado global mejorado
@@ -37,8 +69,16 @@ static BOOL measuring = FALSE;
 static BOOL measurement_ended = FALSE;  // Nueva bandera para terminar completamente
 static BOOL start_found = FALSE;        // Para saber si ya encontramos el start
 static ofstream output_file;
-static stack<string> call_stack;
-static set<string> measured_functions;  // Funciones que están en la región de medición
+static set<UINT32> measured_functions;  // Funciones que están en la región de medición
+
+// Cada rutina se guarda una vez, al instrumentarla; las filas llevan el ID.
+// El ID 0 es UNKNOWN (pila vacia).
+struct SymbolInfo {
+    string name;      // ya undecorado
+    string mangled;
+};
+static vector<SymbolInfo> symbols(1, SymbolInfo{"UNKNOWN", ""});
+static map<string, UINT32> symbol_ids;
 
 // Variables para control de hilos
 static PIN_THREAD_UID main_thread_uid;
@@ -128,51 +168,111 @@ static InstructionType classifyInstruction(INS ins) {
     return UNKNOWN_TYPE;
 }
 
-// Estructura para la clave del mapa
+// Reemplaza el contenido de cada template de primer nivel por "..."
+// (operator<, operator<< y operator<=> no abren template)
+static string collapseTemplates(const string& name) {
+    string out;
+    out.reserve(name.size());
+    int depth = 0;
+    for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        size_t op = out.rfind("operator");
+        if (c == '<' && depth == 0 && op != string::npos &&
+            (op + 8 == out.size() || (op + 9 == out.size() && out.back() == '<'))) {
+            out += c;
+            continue;
+        }
+        if (c == '<') {
+            if (depth++ == 0)
+                out += "<...";
+            continue;
+        }
+        if (c == '>' && depth > 0) {
+            if (--depth == 0)
+                out += '>';
+            continue;
+        }
+        if (depth == 0)
+            out += c;
+    }
+    return out;
+}
+
+static string undecorate(const string& mangled) {
+    string name = mangled;
+    if (KnobUndecorate.Value() == "complete")
+        name = PIN_UndecorateSymbolName(mangled, UNDECORATION_COMPLETE);
+    else if (KnobUndecorate.Value() == "name")
+        name = PIN_UndecorateSymbolName(mangled, UNDECORATION_NAME_ONLY);
+    if (KnobCollapseTemplates.Value())
+        name = collapseTemplates(name);
+    return name;
+}
+
+// Con collapse_templates varias instancias comparten nombre y por lo tanto ID
+static UINT32 internRoutine(const string& mangled) {
+    string name = undecorate(mangled);
+    auto it = symbol_ids.find(name);
+    if (it != symbol_ids.end())
+        return it->second;
+    UINT32 id = static_cast<UINT32>(symbols.size());
+    symbols.push_back(SymbolInfo{name, mangled});
+    symbol_ids[name] = id;
+    return id;
+}
+
+// Arbol de contextos de llamada: un nodo por camino raiz..rutina, con el conteo
+// de cada categoria. Entrar a una rutina baja al hijo (creandolo la primera vez),
+// salir sube al padre. La raiz (id 0) es UNKNOWN: lo ejecutado con la pila vacia.
+struct CctNode {
+    UINT32 func;
+    CctNode* parent;
+    vector<CctNode*> children;
+    UINT64 counts[UNKNOWN_TYPE] = {};
+};
+
+static CctNode cct_root{0, nullptr, {}};
+static CctNode* cct_current = &cct_root;
+static UINT64 cct_nodes = 1;
+
+static CctNode* cctChild(CctNode* node, UINT32 func) {
+    // Pocos hijos por nodo: busqueda lineal, el ultimo usado adelante
+    for (size_t i = 0; i < node->children.size(); ++i) {
+        CctNode* child = node->children[i];
+        if (child->func != func)
+            continue;
+        if (i > 0)
+            std::swap(node->children[i], node->children[0]);
+        return child;
+    }
+    CctNode* child = new CctNode{func, node, {}};
+    node->children.insert(node->children.begin(), child);
+    ++cct_nodes;
+    return child;
+}
+
+// Estructura para la clave del mapa: categoria y la pila recortada (0 = vacio)
 struct CounterKey {
-    string instruction_type;
-    string current_function;
-    string parent_1, parent_2, parent_3, parent_4, parent_5;
-    string parent_6, parent_7, parent_8, parent_9;
+    UINT32 instruction_type;
+    UINT32 hierarchy[CALL_HIERARCHY_DEPTH];   // [0] actual, [1..] padres
 
     bool operator<(const CounterKey& other) const {
-        return tie(instruction_type, current_function, parent_1, parent_2, parent_3,
-                   parent_4, parent_5, parent_6, parent_7, parent_8, parent_9) <
-               tie(other.instruction_type, other.current_function, other.parent_1,
-                   other.parent_2, other.parent_3, other.parent_4, other.parent_5,
-                   other.parent_6, other.parent_7, other.parent_8, other.parent_9);
+        if (instruction_type != other.instruction_type)
+            return instruction_type < other.instruction_type;
+        return std::lexicographical_compare(hierarchy, hierarchy + CALL_HIERARCHY_DEPTH,
+                                            other.hierarchy, other.hierarchy + CALL_HIERARCHY_DEPTH);
     }
 };
 
 static map<CounterKey, UINT64> instruction_counts;
 
-static CounterKey getCallHierarchy(const string& instruction_type) {
+// path va de la raiz (sin incluirla) a la hoja
+static CounterKey getCallHierarchy(UINT32 instruction_type, const vector<UINT32>& path) {
     CounterKey key;
     key.instruction_type = instruction_type;
-    key.current_function = "UNKNOWN";
-    key.parent_1 = key.parent_2 = key.parent_3 = key.parent_4 = key.parent_5 = "";
-    key.parent_6 = key.parent_7 = key.parent_8 = key.parent_9 = "";
-
-    if (!call_stack.empty()) {
-        vector<string> hierarchy;
-        stack<string> temp_stack = call_stack;
-        while (!temp_stack.empty()) {
-            hierarchy.push_back(temp_stack.top());
-            temp_stack.pop();
-        }
-
-        if (hierarchy.size() >= 1) key.current_function = hierarchy[0];
-        if (hierarchy.size() >= 2) key.parent_1 = hierarchy[1];
-        if (hierarchy.size() >= 3) key.parent_2 = hierarchy[2];
-        if (hierarchy.size() >= 4) key.parent_3 = hierarchy[3];
-        if (hierarchy.size() >= 5) key.parent_4 = hierarchy[4];
-        if (hierarchy.size() >= 6) key.parent_5 = hierarchy[5];
-        if (hierarchy.size() >= 7) key.parent_6 = hierarchy[6];
-        if (hierarchy.size() >= 8) key.parent_7 = hierarchy[7];
-        if (hierarchy.size() >= 9) key.parent_8 = hierarchy[8];
-        if (hierarchy.size() >= 10) key.parent_9 = hierarchy[9];
-    }
-
+    size_t depth = path.size();
+    for (int i = 0; i < CALL_HIERARCHY_DEPTH; ++i)
+        key.hierarchy[i] = static_cast<size_t>(i) < depth ? path[depth - 1 - i] : 0;
     return key;
 }
 
@@ -190,26 +290,20 @@ VOID AnalyzeInstruction(UINT32 instruction_type_val) {
     // Solo medir en el hilo principal y durante la medición
     if (!measuring || !IsMainThread()) return;
 
-    InstructionType type = static_cast<InstructionType>(instruction_type_val);
-    string type_str = typeToString(type);
-
-    if (type_str == "UNKNOWN_TYPE") return;
+    if (instruction_type_val == UNKNOWN_TYPE) return;
 
-    CounterKey key = getCallHierarchy(type_str);
-    instruction_counts[key]++;
+    cct_current->counts[instruction_type_val]++;
 }
 
-VOID OnRoutineEntry(std::string* name) {
+VOID OnRoutineEntry(UINT32 func_id) {
     if (measurement_ended) return;
 
-    const std::string &func_name = *name;
-
     // Solo en hilo principal
     if (!IsMainThread()) return;
 
     if (measuring) {
-        call_stack.push(func_name);
-        measured_functions.insert(func_name);
+        cct_current = cctChild(cct_current, func_id);
+        measured_functions.insert(func_id);
     }
 }
 
@@ -219,8 +313,8 @@ VOID OnRoutineExit() {
     // Solo en hilo principal
     if (!IsMainThread()) return;
 
-    if (measuring && !call_stack.empty()) {
-        call_stack.pop();
+    if (measuring && cct_current->parent) {
+        cct_current = cct_current->parent;
     }
 }
 
@@ -280,9 +374,8 @@ VOID InstrumentRoutine(RTN rtn, VOID* v) {
 
     RTN_Open(rtn);
 
-    string* name_ptr = new string(routine_name);
     RTN_InsertCall(rtn, IPOINT_BEFORE, AFUNPTR(OnRoutineEntry),
-                   IARG_PTR, name_ptr, IARG_END);
+                   IARG_UINT32, internRoutine(routine_name), IARG_END);
     RTN_InsertCall(rtn, IPOINT_AFTER, AFUNPTR(OnRoutineExit), IARG_END);
 
     RTN_Close(rtn);
@@ -301,39 +394,299 @@ VOID InstrumentInstruction(INS ins, VOID* v) {
                    IARG_UINT32, type_val, IARG_END);
 }
 
+// -----------------------------------------------------------------
+// Heatmap por linea (-heatmap 1)
+// -----------------------------------------------------------------
+// Un contador por BBL, en bloques de tamaño fijo para que la direccion no se
+// mueva mientras otros hilos instrumentan. Cada instruccion se ejecuta tantas
+// veces como su BBL, asi que por IP alcanza con guardar (direccion, categoria,
+// BBL). Las lineas recien se resuelven en Finish con PIN_GetSourceLocation.
+// Una BBL se identifica por (direccion, instrucciones): una retraduccion que
+// arranca en la misma direccion pero corta en otro lado (un salto nuevo al
+// medio, otro limite de trace) es otra BBL con sus propias instrucciones.
+static const UINT32 HEAT_CHUNK = 1 << 16;
+
+struct HeatIns {
+    ADDRINT addr;
+    UINT32 bbl;
+    UINT32 type;   // UNKNOWN_TYPE cuenta solo en el total
+};
+
+static vector<UINT64*> heat_chunks;
+static UINT32 heat_bbls = 0;
+static map<pair<ADDRINT, UINT32>, UINT32> heat_bbl_ids;
+static vector<HeatIns> heat_ins;
+
+static UINT64* heatCounter(UINT32 bbl) {
+    return heat_chunks[bbl / HEAT_CHUNK] + bbl % HEAT_CHUNK;
+}
+
+VOID CountBbl(UINT64* counter) {
+    if (!measuring || !IsMainThread()) return;
+    ++*counter;
+}
+
+// Instrumentacion con el lock de la VM tomado: los mapas no necesitan mas
+VOID InstrumentTraceHeatmap(TRACE trace, VOID* v) {
+    if (measurement_ended) return;
+
+    for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+        pair<ADDRINT, UINT32> key(BBL_Address(bbl), BBL_NumIns(bbl));
+        auto it = heat_bbl_ids.find(key);
+        UINT32 id;
+        if (it != heat_bbl_ids.end()) {
+            id = it->second;   // la misma BBL (misma extension) retraducida comparte contador
+        } else {
+            id = heat_bbls++;
+            if (id % HEAT_CHUNK == 0)
+                heat_chunks.push_back(new UINT64[HEAT_CHUNK]());
+            heat_bbl_ids[key] = id;
+            for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+                heat_ins.push_back(HeatIns{INS_Address(ins), id, static_cast<UINT32>(classifyInstruction(ins))});
+        }
+        BBL_InsertCall(bbl, IPOINT_BEFORE, AFUNPTR(CountBbl), IARG_PTR, heatCounter(id), IARG_END);
+    }
+}
+
+// Conteos de una linea: [0..UNKNOWN_TYPE) por categoria, [UNKNOWN_TYPE] total
+struct LineCounts {
+    UINT64 counts[UNKNOWN_TYPE + 1] = {};
+};
+
+static string heatFileName(const string& source) {
+    string name = KnobHeatmapPrefix.Value() + "_";
+    for (char c : source)
+        name += (c == '/' || c == '\\' || c == ' ') ? '_' : c;
+    return name + ".txt";
+}
+
+// Copia anotada del fuente: conteo total, % del archivo y la linea
+static VOID WriteAnnotatedSource(const string& source, const map<INT32, LineCounts>& lines) {
+    UINT64 file_total = 0;
+    for (const auto& entry : lines)
+        file_total += entry.second.counts[UNKNOWN_TYPE];
+
+    ofstream out(heatFileName(source).c_str());
+    if (!out.is_open()) {
+        cerr << "[PIN] ERROR: No se pudo abrir " << heatFileName(source) << endl;
+        return;
+    }
+    out << "# " << source << " (" << file_total << " instrucciones)\n";
+    std::ifstream in(source.c_str());
+    if (!in.is_open()) {
+        // Sin el fuente a mano: solo las lineas con conteo
+        for (const auto& entry : lines)
+            out << std::setw(14) << entry.second.counts[UNKNOWN_TYPE] << "  " << std::setw(6) << entry.first << "\n";
+        return;
+    }
+    string text;
+    for (INT32 line = 1; std::getline(in, text); ++line) {
+        auto it = lines.find(line);
+        if (it == lines.end()) {
+            out << std::setw(14) << "" << "        " << std::setw(6) << line << "  " << text << "\n";
+            continue;
+        }
+        UINT64 count = it->second.counts[UNKNOWN_TYPE];
+        double pct = file_total ? 100.0 * count / file_total : 0;
+        out << std::setw(14) << count << std::setw(7) << std::fixed << std::setprecision(2) << pct << "% "
+            << std::setw(6) << line << "  " << text << "\n";
+    }
+}
+
+static VOID WriteHeatmap() {
+    // IP -> archivo:linea, agrupando
+    map<string, map<INT32, LineCounts>> files;
+    UINT64 unresolved = 0;
+    PIN_LockClient();
+    for (const HeatIns& ins : heat_ins) {
+        UINT64 count = *heatCounter(ins.bbl);
+        if (!count)
+            continue;
+        INT32 column = 0, line = 0;
+        string file;
+        PIN_GetSourceLocation(ins.addr, &column, &line, &file);
+        if (file.empty() || line <= 0) {
+            unresolved += count;
+            continue;
+        }
+        LineCounts& lc = files[file][line];
+        lc.counts[UNKNOWN_TYPE] += count;
+        if (ins.type != UNKNOWN_TYPE)
+            lc.counts[ins.type] += count;
+    }
+    PIN_UnlockClient();
+
+    for (const auto& entry : files)
+        WriteAnnotatedSource(entry.first, entry.second);
+
+    // Top N lineas por categoria (y por total)
+    string hot_path = KnobHeatmapPrefix.Value() + "_hot_lines.txt";
+    ofstream hot(hot_path.c_str());
+    if (!hot.is_open()) {
+        cerr << "[PIN] ERROR: No se pudo abrir " << hot_path << endl;
+        return;
+    }
+    hot << "Tipo_Instruccion,Rank,Conteo,Archivo,Linea\n";
+    typedef std::pair<UINT64, std::pair<const string*, INT32> > Hot;
+    for (int t = UNKNOWN_TYPE; t >= 0; --t) {
+        vector<Hot> ranked;
+        for (const auto& file : files)
+            for (const auto& line : file.second)
+                if (line.second.counts[t])
+                    ranked.push_back(Hot(line.second.counts[t], std::make_pair(&file.first, line.first)));
+        size_t keep = std::min<size_t>(ranked.size(), KnobHeatmapTop.Value());
+        std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(),
+                          [](const Hot& a, const Hot& b) { return a.first > b.first; });
+        string name = t == UNKNOWN_TYPE ? string("TOTAL") : typeToString(static_cast<InstructionType>(t));
+        for (size_t i = 0; i < keep; ++i)
+            hot << name << "," << i + 1 << "," << ranked[i].first << "," << *ranked[i].second.first << ","
+                << ranked[i].second.second << "\n";
+    }
+    hot.close();
+    cout << "[PIN] Heatmap: " << files.size() << " archivos fuente, " << heat_bbls << " BBLs, "
+         << unresolved << " instrucciones sin linea; top en " << hot_path << endl;
+}
+
+// Una sola pasada en profundidad por el arbol: cada nodo con conteos va como
+// linea del .folded, como muestra del pprof y a la clave del CSV (ultimos
+// CALL_HIERARCHY_DEPTH niveles). Iterativo: el arbol puede ser muy profundo.
+static VOID WriteCallingContexts(ofstream* folded, PprofWriter* pprof) {
+    vector<UINT32> path;                       // funciones de la raiz a la hoja
+    vector<std::pair<CctNode*, size_t>> stack;  // nodo y proximo hijo a visitar
+    vector<size_t> prefix_len;                 // largo del prefijo folded por nivel
+    string prefix;
+    vector<uint64_t> locations;
+    vector<int64_t> values(UNKNOWN_TYPE);
+
+    stack.push_back({&cct_root, 0});
+    prefix_len.push_back(0);
+    while (!stack.empty()) {
+        CctNode* node = stack.back().first;
+        size_t& next = stack.back().second;
+        if (next == 0) {
+            // Primera visita: emitir el nodo
+            bool any = false;
+            for (int t = 0; t < UNKNOWN_TYPE; ++t)
+                any |= node->counts[t] != 0;
+            if (any) {
+                locations.clear();
+                if (path.empty())
+                    locations.push_back(1);   // UNKNOWN
+                for (size_t i = path.size(); i-- > 0;)
+                    locations.push_back(static_cast<uint64_t>(path[i]) + 1);
+                for (int t = 0; t < UNKNOWN_TYPE; ++t) {
+                    UINT64 count = node->counts[t];
+                    values[t] = static_cast<int64_t>(count);
+                    if (!count)
+                        continue;
+                    instruction_counts[getCallHierarchy(t, path)] += count;
+                    if (folded)
+                        *folded << (path.empty() ? string("UNKNOWN;") : prefix)
+                                << typeToString(static_cast<InstructionType>(t)) << " " << count << "\n";
+                }
+                if (pprof)
+                    pprof->Sample(locations, values);
+            }
+        }
+        if (next < node->children.size()) {
+            CctNode* child = node->children[next++];
+            path.push_back(child->func);
+            prefix.resize(prefix_len.back());
+            prefix += symbols[child->func].name;
+            prefix += ';';
+            prefix_len.push_back(prefix.size());
+            stack.push_back({child, 0});
+            continue;
+        }
+        stack.pop_back();
+        prefix_len.pop_back();
+        if (!path.empty())
+            path.pop_back();
+        prefix.resize(prefix_len.empty() ? 0 : prefix_len.back());
+    }
+}
+
 VOID Finish(INT32 code, VOID* v) {
     cout << "[PIN] Escribiendo resultados..." << endl;
     cout << "[PIN] Total de funciones en región medida: " << measured_functions.size() << endl;
+    cout << "[PIN] Nodos del arbol de llamadas: " << cct_nodes << endl;
 
-    output_file << "Tipo_Instruccion,Conteo,Funcion_Actual,Funcion_Padre_1,Funcion_Padre_2,";
-    output_file << "Funcion_Padre_3,Funcion_Padre_4,Funcion_Padre_5,Funcion_Padre_6,";
-    output_file << "Funcion_Padre_7,Funcion_Padre_8,Funcion_Padre_9\n";
+    ofstream folded_file;
+    if (!KnobFolded.Value().empty()) {
+        folded_file.open(KnobFolded.Value().c_str());
+        if (!folded_file.is_open())
+            cerr << "[PIN] ERROR: No se pudo abrir " << KnobFolded.Value() << endl;
+    }
+    ofstream pprof_file;
+    if (!KnobPprof.Value().empty()) {
+        pprof_file.open(KnobPprof.Value().c_str(), std::ios::binary);
+        if (!pprof_file.is_open())
+            cerr << "[PIN] ERROR: No se pudo abrir " << KnobPprof.Value() << endl;
+    }
+    PprofWriter pprof(pprof_file);
+    if (pprof_file.is_open()) {
+        for (int t = 0; t < UNKNOWN_TYPE; ++t)
+            pprof.SampleType(typeToString(static_cast<InstructionType>(t)), "count");
+    }
+    WriteCallingContexts(folded_file.is_open() ? &folded_file : nullptr,
+                         pprof_file.is_open() ? &pprof : nullptr);
+    if (folded_file.is_open()) {
+        folded_file.close();
+        cout << "[PIN] Stacks colapsados en " << KnobFolded.Value() << endl;
+    }
+    if (pprof_file.is_open()) {
+        for (UINT32 id = 0; id < symbols.size(); ++id)
+            pprof.Function(static_cast<uint64_t>(id) + 1, symbols[id].name);
+        pprof.Finish("openfhe_counter: instrucciones por categoria entre start_measurement y end_measurement");
+        pprof_file.close();
+        cout << "[PIN] Perfil pprof en " << KnobPprof.Value() << endl;
+    }
+    if (KnobHeatmap.Value())
+        WriteHeatmap();
+
+    // Columnas _Id: los nombres estan en la tabla de simbolos
+    output_file << "Tipo_Instruccion,Conteo,Funcion_Actual_Id";
+    for (int i = 1; i < CALL_HIERARCHY_DEPTH; ++i)
+        output_file << ",Funcion_Padre_" << i << "_Id";
+    output_file << "\n";
 
+    // Los padres vacios quedan como campo vacio, igual que antes
     for (const auto& entry : instruction_counts) {
         const CounterKey& key = entry.first;
         UINT64 count = entry.second;
 
-        output_file << key.instruction_type << ","
+        output_file << typeToString(static_cast<InstructionType>(key.instruction_type)) << ","
                    << count << ","
-                   << key.current_function << ","
-                   << key.parent_1 << ","
-                   << key.parent_2 << ","
-                   << key.parent_3 << ","
-                   << key.parent_4 << ","
-                   << key.parent_5 << ","
-                   << key.parent_6 << ","
-                   << key.parent_7 << ","
-                   << key.parent_8 << ","
-                   << key.parent_9 << "\n";
+                   << key.hierarchy[0];
+        for (int i = 1; i < CALL_HIERARCHY_DEPTH; ++i) {
+            output_file << ",";
+            if (key.hierarchy[i])
+                output_file << key.hierarchy[i];
+        }
+        output_file << "\n";
     }
 
     output_file.close();
-    cout << "[PIN] Resultados escritos en openfhe_ckks_counts.csv" << endl;
+    cout << "[PIN] Resultados escritos en " << KnobOutput.Value() << endl;
+
+    ofstream symbols_file(KnobSymbols.Value().c_str());
+    if (!symbols_file.is_open()) {
+        cerr << "[PIN] ERROR: No se pudo abrir la tabla de simbolos " << KnobSymbols.Value() << endl;
+        return;
+    }
+    symbols_file << "Id\tNombre\tSimbolo\n";
+    for (UINT32 id = 0; id < symbols.size(); ++id)
+        symbols_file << id << "\t" << symbols[id].name << "\t" << symbols[id].mangled << "\n";
+    symbols_file.close();
+    cout << "[PIN] Tabla de simbolos en " << KnobSymbols.Value() << " (" << symbols.size() << " rutinas)" << endl;
     cout << "[PIN] Total de entradas únicas: " << instruction_counts.size() << endl;
 }
 
 INT32 Usage() {
-    cerr << "Uso: pin -t obj-intel64/openfhe_ckks_counter.so -- <programa_openfhe>" << endl;
+    cerr << "Uso: pin -t obj-intel64/openfhe_ckks_counter.so [-o counts.csv] [-symbols tabla.tsv] "
+            "[-undecorate complete|name|none] [-collapse_templates 1] [-folded f.folded] [-pprof f.pb] [-heatmap 1] "
+            "-- <programa_openfhe>" << endl;
+    cerr << KNOB_BASE::StringKnobSummary() << endl;
     cerr << "El programa debe tener funciones start_measurement() y end_measurement()" << endl;
     return -1;
 }
@@ -345,7 +698,7 @@ int main(int argc, char* argv[]) {
         return Usage();
     }
 
-    output_file.open("openfhe_ckks_counts.csv");
+    output_file.open(KnobOutput.Value().c_str());
     if (!output_file.is_open()) {
         cerr << "[PIN] ERROR: No se pudo abrir el archivo CSV de salida" << endl;
         return 1;
@@ -353,6 +706,8 @@ int main(int argc, char* argv[]) {
 
     RTN_AddInstrumentFunction(InstrumentRoutine, nullptr);
     INS_AddInstrumentFunction(InstrumentInstruction, nullptr);
+    if (KnobHeatmap.Value())
+        TRACE_AddInstrumentFunction(InstrumentTraceHeatmap, nullptr);
     PIN_AddFiniFunction(Finish, nullptr);
 
     cout << "[PIN] OpenFHE CKKS Instruction Counter iniciado (mejorado)" << endl;
@@ -0,0 +1,119 @@
+#ifndef PPROF_WRITER_MATI_H
+#define PPROF_WRITER_MATI_H
+
+// Escritor minimo del formato profile.proto de pprof, sin libprotobuf (Pin no
+// la trae). Los campos repetidos de Profile pueden ir en cualquier orden, asi
+// que las muestras se escriben a medida que se recorren y la tabla de
+// funciones y strings al final:
+//
+//   PprofWriter pprof(out);
+//   pprof.SampleType("INT_ADD", "count");        // uno por valor de las muestras
+//   pprof.Sample(locationIds, values);           // hoja primero
+//   pprof.Function(id, "lbcrypto::...");         // location id == function id
+//   pprof.Finish();                              // escribe la string table
+//
+// La salida es el protobuf sin comprimir; pprof acepta tanto eso como .pb.gz.
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class PprofWriter {
+public:
+    explicit PprofWriter(std::ostream& out) : out_(out) { Intern(""); }
+
+    void SampleType(const std::string& type, const std::string& unit) {
+        std::string msg;
+        PutInt(msg, 1, Intern(type));
+        PutInt(msg, 2, Intern(unit));
+        PutBytes(top_, 1, msg);
+        Flush();
+    }
+
+    void Sample(const std::vector<uint64_t>& locations, const std::vector<int64_t>& values) {
+        std::string packed, msg;
+        for (uint64_t id : locations)
+            PutVarint(packed, id);
+        PutBytes(msg, 1, packed);
+        packed.clear();
+        for (int64_t v : values)
+            PutVarint(packed, static_cast<uint64_t>(v));
+        PutBytes(msg, 2, packed);
+        PutBytes(top_, 2, msg);
+        Flush();
+    }
+
+    // Una location por funcion, con el mismo id (> 0). line 0 si no hay fuente.
+    void Function(uint64_t id, const std::string& name, const std::string& file = "", int64_t line = 0) {
+        std::string msg, lineMsg;
+        PutInt(msg, 1, id);
+        PutInt(msg, 2, Intern(name));
+        PutInt(msg, 3, Intern(name));
+        if (!file.empty())
+            PutInt(msg, 4, Intern(file));
+        PutBytes(top_, 5, msg);
+
+        msg.clear();
+        PutInt(msg, 1, id);
+        PutInt(lineMsg, 1, id);
+        if (line > 0)
+            PutInt(lineMsg, 2, static_cast<uint64_t>(line));
+        PutBytes(msg, 4, lineMsg);
+        PutBytes(top_, 4, msg);
+        Flush();
+    }
+
+    void Finish(const std::string& comment = "") {
+        if (!comment.empty())
+            PutInt(top_, 13, Intern(comment));
+        for (const std::string& s : strings_)
+            PutBytes(top_, 6, s);
+        Flush(true);
+        out_.flush();
+    }
+
+private:
+    uint64_t Intern(const std::string& s) {
+        auto it = stringIds_.find(s);
+        if (it != stringIds_.end())
+            return it->second;
+        uint64_t id = strings_.size();
+        strings_.push_back(s);
+        stringIds_.emplace(s, id);
+        return id;
+    }
+
+    static void PutVarint(std::string& buf, uint64_t v) {
+        while (v >= 0x80) {
+            buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        buf.push_back(static_cast<char>(v));
+    }
+
+    static void PutInt(std::string& buf, uint32_t field, uint64_t v) {
+        PutVarint(buf, static_cast<uint64_t>(field) << 3);   // wire type 0
+        PutVarint(buf, v);
+    }
+
+    static void PutBytes(std::string& buf, uint32_t field, const std::string& bytes) {
+        PutVarint(buf, (static_cast<uint64_t>(field) << 3) | 2);   // wire type 2
+        PutVarint(buf, bytes.size());
+        buf.append(bytes);
+    }
+
+    void Flush(bool force = false) {
+        if (!force && top_.size() < (1 << 16))
+            return;
+        out_.write(top_.data(), static_cast<std::streamsize>(top_.size()));
+        top_.clear();
+    }
+
+    std::ostream& out_;
+    std::string top_;   // buffer de salida
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint64_t> stringIds_;
+};
+#endif
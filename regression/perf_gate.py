@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+Gate de regresion de performance para las campañas.
+
+Corre build/bin/perf_gate (campaña fija: logN=10, un limb, bits muestreados)
+y compara contra el baseline:
+  - nativo: flips/s con el flip hecho en el proceso no puede caer mas que la
+    tolerancia, y el checksum de outcomes tiene que coincidir
+  - limpio: perf_gate en modo pin sin Pin (nadie inyecta, todo MASKED); es la
+    referencia del slowdown y el checksum de "no hubo fault"
+  - cada pintool de perf_baseline.json corre sobre perf_gate en modo pin con
+    knobs deterministas que ejercitan su camino real de inyeccion (marcadores
+    addr_label/sync_marker/report_norm, rutinas perf_gate_decrypt y
+    perf_gate_metrics). Su slowdown (flips/s limpio / flips/s bajo Pin) no
+    puede subir mas que la tolerancia y su checksum tiene que ser el del
+    baseline. Una pintool con "injects" que da el checksum limpio no inyecto
+    nada; una sin "injects" tiene que dar el checksum limpio.
+Un caso sin baseline falla: grabarlo con --update en la maquina de referencia.
+Mientras el baseline este vacio (nunca se corrio --update) solo cuentan los
+chequeos que no dependen de el (que cada pintool inyecte o no); --strict hace
+fallar tambien los casos sin baseline.
+
+En los args de cada pintool {tmp} es el directorio de la corrida, donde
+perf_gate deja target_address.txt y target_coeffs.txt.
+
+Uso:
+  ./regression/perf_gate.py                 # gate completo, exit 1 si falla
+  ./regression/perf_gate.py --native-only   # solo el binario, sin Pin
+  ./regression/perf_gate.py --tools BitFlip,openfhe_counter
+  ./regression/perf_gate.py --update        # graba lo medido como baseline
+  ./regression/perf_gate.py --strict        # falla aunque el baseline este vacio
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Callable, Dict, List, Optional
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BASELINE = os.path.join(ROOT, "regression", "perf_baseline.json")
+
+
+def run_gate(make_cmd: Callable[[str, str], List[str]], repeats: int) -> Dict:
+    """Corre perf_gate repeats veces y se queda con la corrida mas rapida.
+    make_cmd(tmp, out) arma el comando de cada corrida."""
+    best = None
+    checksums = set()
+    for _ in range(repeats):
+        with tempfile.TemporaryDirectory() as tmp:
+            out = os.path.join(tmp, "perf_gate.json")
+            cmd = make_cmd(tmp, out)
+            t0 = time.monotonic()
+            proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+            wall = time.monotonic() - t0
+            if proc.returncode != 0 or not os.path.exists(out):
+                print(f"[ERROR] Fallo: {' '.join(cmd)} (exit {proc.returncode})")
+                print(proc.stderr[-2000:])
+                sys.exit(2)
+            with open(out, 'r', encoding='utf-8') as f:
+                res = json.load(f)
+        res["wall"] = wall
+        checksums.add(res["checksum"])
+        if best is None or res["flips_per_sec"] > best["flips_per_sec"]:
+            best = res
+    if len(checksums) > 1:
+        # La campaña es determinista: distintos checksums entre repeticiones ya es un bug
+        best["checksum"] = "inestable:" + ",".join(sorted(checksums))
+    return best
+
+
+def pct(actual: float, base: float) -> str:
+    return f"{(actual / base - 1) * 100:+.1f}%" if base else "-"
+
+
+class Report:
+    def __init__(self, missing_fails: bool):
+        self.rows = []
+        self.failed = False
+        self.missing_fails = missing_fails
+
+    def add(self, name: str, metric: str, base, actual, limit: str, ok: Optional[bool], delta: str = "-",
+            info: bool = False):
+        """ok=None: no hay baseline para comparar, falla salvo con el baseline vacio"""
+        status = "info" if info else ("sin baseline" if ok is None else ("OK" if ok else "FAIL"))
+        if not info and (ok is False or (ok is None and self.missing_fails)):
+            self.failed = True
+        self.rows.append((name, metric, "-" if base is None else str(base), str(actual), delta, limit, status))
+
+    def print(self):
+        header = ("caso", "metrica", "baseline", "actual", "delta", "limite", "estado")
+        widths = [max(len(r[i]) for r in self.rows + [header]) for i in range(len(header))]
+        fmt = "  ".join("{:<%d}" % w for w in widths)
+        print(fmt.format(*header))
+        print(fmt.format(*("-" * w for w in widths)))
+        for r in self.rows:
+            print(fmt.format(*r))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gate de regresion de flips/s y slowdown de Pin")
+    parser.add_argument("--baseline", default=BASELINE, help="JSON con baselines y tolerancias")
+    parser.add_argument("--gate-bin", default=os.path.join(ROOT, "build", "bin", "perf_gate"))
+    parser.add_argument("--pin", default=os.path.join(ROOT, "pin", "pin"), help="Ejecutable de Pin")
+    parser.add_argument("--tools", help="Lista separada por comas (por defecto todas las del baseline)")
+    parser.add_argument("--native-only", action="store_true", help="No correr bajo Pin")
+    parser.add_argument("--repeats", type=int, help="Corridas por caso (se toma la mas rapida)")
+    parser.add_argument("--build", action="store_true", help="Compilar las pintools que falten")
+    parser.add_argument("--update", action="store_true", help="Grabar lo medido como nuevo baseline")
+    parser.add_argument("--strict", action="store_true", help="Fallar en los casos sin baseline aunque este vacio")
+    args = parser.parse_args()
+
+    with open(args.baseline, 'r', encoding='utf-8') as f:
+        baseline = json.load(f)
+    repeats = args.repeats or baseline.get("repeats", 3)
+
+    if not os.path.exists(args.gate_bin):
+        print(f"[ERROR] No existe {args.gate_bin}, compilar el target perf_gate")
+        sys.exit(2)
+
+    tools = {} if args.native_only else baseline["tools"]
+    if args.tools:
+        wanted = args.tools.split(",")
+        unknown = [t for t in wanted if t not in baseline["tools"]]
+        if unknown:
+            print(f"[ERROR] Pintools desconocidas: {', '.join(unknown)}")
+            sys.exit(2)
+        tools = {t: baseline["tools"][t] for t in wanted}
+
+    gate = args.gate_bin
+    print(f"[INFO] nativo ({repeats} corridas)")
+    native = run_gate(lambda tmp, out: [gate, out, "native"], repeats)
+    print(f"[INFO] limpio ({repeats} corridas)")
+    clean = run_gate(lambda tmp, out: [gate, out, "pin"], repeats)
+    measured = {}
+    for name, tool in tools.items():
+        so = os.path.join(ROOT, tool["so"])
+        if not os.path.exists(so) and args.build:
+            subprocess.run(tool["build"], cwd=ROOT, check=False)
+        if not os.path.exists(so):
+            print(f"[ERROR] No existe {tool['so']}: correr {' '.join(tool['build'])} o usar --build")
+            sys.exit(2)
+        print(f"[INFO] {name} ({repeats} corridas)")
+        measured[name] = run_gate(
+            lambda tmp, out, so=so, tool=tool: [args.pin, "-t", so] +
+            [a.replace("{tmp}", tmp) for a in tool["args"]] + ["--", gate, out, "pin"],
+            repeats)
+
+    # Baseline vacio: todavia no se grabo en la maquina de referencia, el gate no puede comparar
+    recorded = baseline["native"]["checksum"] is not None
+    report = Report(missing_fails=recorded or args.strict)
+    if baseline.get("openfhe") and baseline["openfhe"] != native["openfhe"]:
+        print(f"[WARN] Baseline medido con OpenFHE {baseline['openfhe']}, ahora {native['openfhe']}")
+
+    def check_sum(name: str, res: Dict, base_sum: Optional[str]):
+        report.add(name, "checksum", base_sum, res["checksum"], "==",
+                   None if base_sum is None else res["checksum"] == base_sum)
+
+    check_sum("nativo", native, baseline["native"]["checksum"])
+    check_sum("limpio", clean, baseline["clean"]["checksum"])
+
+    base_fps = baseline["native"]["flips_per_sec"]
+    tol = baseline["native"]["tolerance"]
+    fps = native["flips_per_sec"]
+    report.add("nativo", "flips/s", base_fps, f"{fps:.1f}",
+               "-" if base_fps is None else f">= {base_fps * (1 - tol):.1f}",
+               None if base_fps is None else fps >= base_fps * (1 - tol),
+               pct(fps, base_fps) if base_fps else "-")
+
+    # No depende del baseline: la pintool tiene que inyectar (o no) lo que dice
+    path_errors = []
+    for name, res in measured.items():
+        tool = tools[name]
+        check_sum(name, res, tool["checksum"])
+        injected = res["checksum"] != clean["checksum"]
+        report.add(name, "inyecta", None, str(injected).lower(),
+                   "!= limpio" if tool["injects"] else "== limpio", injected == tool["injects"])
+        if injected != tool["injects"]:
+            path_errors.append(name)
+
+        slowdown = clean["flips_per_sec"] / res["flips_per_sec"]
+        res["slowdown"] = slowdown
+        base_sd = tool["slowdown"]
+        report.add(name, "slowdown", base_sd, f"{slowdown:.2f}x",
+                   "-" if base_sd is None else f"<= {base_sd * (1 + tool['tolerance']):.2f}x",
+                   None if base_sd is None else slowdown <= base_sd * (1 + tool["tolerance"]),
+                   pct(slowdown, base_sd) if base_sd else "-")
+        # Informativo: incluye el arranque de Pin y el JIT, no se usa para el gate
+        report.add(name, "wall", None, f"{res['wall'] / clean['wall']:.2f}x", "-", None, info=True)
+
+    print()
+    report.print()
+
+    if args.update:
+        unstable = [name for name, res in [("nativo", native), ("limpio", clean)] + list(measured.items())
+                    if res["checksum"].startswith("inestable")]
+        if unstable or path_errors:
+            print(f"[ERROR] Checksums inestables ({', '.join(unstable) or '-'}) o pintools que no siguen "
+                  f"su camino de inyeccion ({', '.join(path_errors) or '-'}), no actualizo el baseline")
+            sys.exit(1)
+        baseline["openfhe"] = native["openfhe"]
+        baseline["native"]["checksum"] = native["checksum"]
+        baseline["native"]["flips_per_sec"] = round(fps, 1)
+        baseline["clean"]["checksum"] = clean["checksum"]
+        for name, res in measured.items():
+            baseline["tools"][name]["checksum"] = res["checksum"]
+            baseline["tools"][name]["slowdown"] = round(res["slowdown"], 2)
+        with open(args.baseline, 'w', encoding='utf-8') as f:
+            json.dump(baseline, f, indent=2)
+            f.write("\n")
+        print(f"\nBaseline actualizado en {args.baseline}")
+        return
+
+    if report.failed:
+        if any(r[6] == "sin baseline" for r in report.rows):
+            print("\n[ERROR] Hay casos sin baseline: correr con --update en la maquina de referencia")
+        print("\n[ERROR] Regresion de performance o de resultados respecto al baseline")
+        sys.exit(1)
+    if not recorded:
+        print("\n[WARN] perf_baseline.json esta vacio: solo se chequeo el camino de inyeccion, "
+              "grabar el baseline con --update en la maquina de referencia")
+        return
+    print("\nGate OK")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+#include "abft.h"
+
+#include <random>
+
+using u128 = unsigned __int128;
+
+static inline uint64_t mulMod(uint64_t a, uint64_t b, uint64_t q) {
+    return static_cast<uint64_t>((static_cast<u128>(a) * b) % q);
+}
+
+static uint64_t powMod(uint64_t b, uint64_t e, uint64_t q) {
+    uint64_t r = 1 % q;
+    for (b %= q; e; e >>= 1, b = mulMod(b, b, q))
+        if (e & 1) r = mulMod(r, b, q);
+    return r;
+}
+
+// sum_i w_i * a_i mod q. a_i puede no ser canonico (fault), se reduce como haria OpenFHE.
+// Con q < 2^60 y a_i < 2^64 cada producto es < 2^124: se reduce cada 8 terminos.
+static uint64_t dot(const std::vector<uint64_t>& w, const NativeVector& a, uint64_t q) {
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(&a[0]);
+    u128 acc = 0;
+    size_t n = w.size();
+    for (size_t i = 0; i < n; ++i) {
+        acc += static_cast<u128>(w[i]) * words[i];
+        if ((i & 7) == 7)
+            acc %= q;
+    }
+    return static_cast<uint64_t>(acc % q);
+}
+
+Abft::Abft(uint64_t seed) : m_seed(seed) {}
+
+const Abft::LimbWeights& Abft::weights(const std::shared_ptr<ILNativeParams>& params) {
+    uint64_t q = params->GetModulus().ConvertToInt();
+    uint32_t n = params->GetRingDimension();
+    auto key = std::make_pair(q, n);
+    auto it = m_weights.find(key);
+    if (it != m_weights.end())
+        return it->second;
+
+    // Raices de X^N + 1 en el orden de evaluacion de OpenFHE
+    NativePoly x(params, Format::COEFFICIENT, true);
+    x[1] = NativeInteger(1);
+    x.SetFormat(Format::EVALUATION);
+    std::vector<uint64_t> roots(n);
+    for (uint32_t j = 0; j < n; ++j)
+        roots[j] = x[j].ConvertToInt();
+
+    // r secreto, no raiz (r^N + 1 != 0) y distinto de todo x_j
+    std::mt19937_64 rng(m_seed ^ q);
+    uint64_t r = 0, rn1 = 0;
+    while (true) {
+        r = std::uniform_int_distribution<uint64_t>(2, q - 1)(rng);
+        rn1 = (powMod(r, n, q) + 1) % q;
+        if (rn1 != 0)
+            break;
+    }
+
+    LimbWeights& lw = m_weights[key];
+    lw.q = q;
+    lw.coeff.resize(n);
+    lw.coeff[0] = 1;
+    for (uint32_t i = 1; i < n; ++i)
+        lw.coeff[i] = mulMod(lw.coeff[i - 1], r, q);
+
+    NativeInteger qn(q);
+    uint64_t nInv = NativeInteger(n).ModInverse(qn).ConvertToInt();
+    uint64_t scale = mulMod(q - rn1, nInv, q);   // -(r^N + 1) / N
+    lw.eval.resize(n);
+    for (uint32_t j = 0; j < n; ++j) {
+        uint64_t diff = r >= roots[j] ? r - roots[j] : r + q - roots[j];
+        uint64_t inv = NativeInteger(diff).ModInverse(qn).ConvertToInt();
+        lw.eval[j] = mulMod(mulMod(roots[j], scale, q), inv, q);
+    }
+    return lw;
+}
+
+std::vector<uint64_t> Abft::checksum(const DCRTPoly& p) {
+    const auto& limbParams = p.GetParams()->GetParams();
+    std::vector<uint64_t> sums(limbParams.size());
+    for (size_t l = 0; l < limbParams.size(); ++l) {
+        const LimbWeights& lw = weights(limbParams[l]);
+        const auto& w = p.GetFormat() == Format::EVALUATION ? lw.eval : lw.coeff;
+        sums[l] = dot(w, p.GetElementAtIndex(l).GetValues(), lw.q);
+    }
+    return sums;
+}
+
+AbftSeal Abft::seal(const ConstCiphertext<DCRTPoly>& c) {
+    AbftSeal s;
+    for (const auto& e : c->GetElements())
+        s.sums.push_back(checksum(e));
+    return s;
+}
+
+bool Abft::record(bool ok) {
+    ++m_checks;
+    if (!ok)
+        ++m_detections;
+    return ok;
+}
+
+bool Abft::verify(const DCRTPoly& p, const std::vector<uint64_t>& sums) {
+    return record(checksum(p) == sums);
+}
+
+bool Abft::verify(const ConstCiphertext<DCRTPoly>& c, const AbftSeal& seal) {
+    const auto& elems = c->GetElements();
+    bool ok = elems.size() == seal.sums.size();
+    for (size_t e = 0; ok && e < elems.size(); ++e)
+        ok = checksum(elems[e]) == seal.sums[e];
+    return record(ok);
+}
+
+bool Abft::switchFormat(DCRTPoly& p) {
+    std::vector<uint64_t> before = checksum(p);
+    p.SwitchFormat();
+    return verify(p, before);
+}
+
+bool Abft::encrypt(const CryptoContext<DCRTPoly>& cc, const PublicKey<DCRTPoly>& publicKey, Plaintext& ptxt,
+                   Ciphertext<DCRTPoly>& out, AbftSeal& seal) {
+    out = cc->Encrypt(publicKey, ptxt);
+    bool canonical = true;
+    for (const auto& e : out->GetElements()) {
+        for (const auto& limb : e.GetAllElements()) {
+            uint64_t q = limb.GetModulus().ConvertToInt();
+            const uint64_t* words = reinterpret_cast<const uint64_t*>(&limb[0]);
+            for (uint32_t i = 0; i < limb.GetLength(); ++i)
+                canonical &= words[i] < q;
+        }
+    }
+    seal = this->seal(out);
+    return record(canonical);
+}
+
+bool Abft::decrypt(const CryptoContext<DCRTPoly>& cc, const PrivateKey<DCRTPoly>& secretKey,
+                   const ConstCiphertext<DCRTPoly>& c, const AbftSeal& seal, Plaintext* result) {
+    bool ok = verify(c, seal);
+    cc->Decrypt(secretKey, c, result);
+    return ok;
+}
+
+bool Abft::evalAdd(const CryptoContext<DCRTPoly>& cc, const ConstCiphertext<DCRTPoly>& a, const AbftSeal& sealA,
+                   const ConstCiphertext<DCRTPoly>& b, const AbftSeal& sealB, Ciphertext<DCRTPoly>& out,
+                   AbftSeal& sealOut) {
+    out = cc->EvalAdd(a, b);
+    const auto& limbParams = out->GetElements()[0].GetParams()->GetParams();
+    sealOut.sums.assign(out->GetElements().size(), std::vector<uint64_t>(limbParams.size(), 0));
+    for (size_t e = 0; e < sealOut.sums.size(); ++e) {
+        for (size_t l = 0; l < limbParams.size(); ++l) {
+            uint64_t q = limbParams[l]->GetModulus().ConvertToInt();
+            uint64_t sa = e < sealA.sums.size() && l < sealA.sums[e].size() ? sealA.sums[e][l] : 0;
+            uint64_t sb = e < sealB.sums.size() && l < sealB.sums[e].size() ? sealB.sums[e][l] : 0;
+            sealOut.sums[e][l] = (sa + sb) % q;
+        }
+    }
+    return verify(out, sealOut);
+}
@@ -0,0 +1,78 @@
+#ifndef ABFT_MATI_H
+#define ABFT_MATI_H
+
+#include "openfhe.h"
+
+#include <vector>
+#include <map>
+#include <cstdint>
+using namespace lbcrypto;
+
+// Checksums ABFT sobre los DCRTPoly que tocan las campañas.
+//
+// Por limb el checksum es la evaluacion del polinomio en un punto secreto r:
+//   s_l = a(r) mod q_l
+// En coeficientes son pesos r^i; en evaluacion el mismo valor sale por
+// Lagrange sobre las raices x_j de X^N + 1 (x_j = NTT(X)_j, asi se respeta el
+// orden de OpenFHE):
+//   a(r) = sum_j A_j * L_j(r),   L_j(r) = -x_j (r^N + 1) / (N (r - x_j))
+// Entonces el checksum no depende del formato (SwitchFormat lo preserva) y es
+// lineal (EvalAdd: s(a+b) = s(a) + s(b)). Cuesta un producto escalar por limb.
+//
+// Cubre: SwitchFormat, el cifrado entre Encrypt y Decrypt y EvalAdd. No cubre
+// Rescale ni automorfismos (cambian el punto de evaluacion), ni Encrypt en si:
+// el sello se calcula sobre su salida, un fault adentro de Encrypt queda
+// sellado. Ahi solo se chequea que los residuos sean canonicos.
+
+// Checksums de un cifrado: [elemento][limb]
+struct AbftSeal {
+    std::vector<std::vector<uint64_t>> sums;
+};
+
+class Abft {
+public:
+    explicit Abft(uint64_t seed = 1);
+
+    // a(r) mod q_l de cada limb, en el formato en que este p
+    std::vector<uint64_t> checksum(const DCRTPoly& p);
+    AbftSeal seal(const ConstCiphertext<DCRTPoly>& c);
+
+    // true si los checksums coinciden (sin fault detectado)
+    bool verify(const DCRTPoly& p, const std::vector<uint64_t>& sums);
+    bool verify(const ConstCiphertext<DCRTPoly>& c, const AbftSeal& seal);
+
+    // Llamadas de OpenFHE con chequeo. Devuelven false si detectan un fault;
+    // el resultado se calcula igual.
+    bool switchFormat(DCRTPoly& p);
+    // Sella el cifrado y chequea que los residuos sean canonicos (< q_l). No
+    // hay checksum contra el que comparar: un fault que deja los residuos en
+    // rango no se detecta
+    bool encrypt(const CryptoContext<DCRTPoly>& cc, const PublicKey<DCRTPoly>& publicKey, Plaintext& ptxt,
+                 Ciphertext<DCRTPoly>& out, AbftSeal& seal);
+    // Verifica el sello antes de descifrar
+    bool decrypt(const CryptoContext<DCRTPoly>& cc, const PrivateKey<DCRTPoly>& secretKey,
+                 const ConstCiphertext<DCRTPoly>& c, const AbftSeal& seal, Plaintext* result);
+    // EvalAdd con el checksum predicho s(a) + s(b)
+    bool evalAdd(const CryptoContext<DCRTPoly>& cc, const ConstCiphertext<DCRTPoly>& a, const AbftSeal& sealA,
+                 const ConstCiphertext<DCRTPoly>& b, const AbftSeal& sealB, Ciphertext<DCRTPoly>& out,
+                 AbftSeal& sealOut);
+
+    uint64_t checks() const { return m_checks; }
+    uint64_t detections() const { return m_detections; }
+
+private:
+    struct LimbWeights {
+        uint64_t q;
+        std::vector<uint64_t> coeff;   // r^i
+        std::vector<uint64_t> eval;    // L_j(r)
+    };
+
+    const LimbWeights& weights(const std::shared_ptr<ILNativeParams>& params);
+    bool record(bool ok);
+
+    uint64_t m_seed;
+    std::map<std::pair<uint64_t, uint32_t>, LimbWeights> m_weights;   // por (q, N)
+    uint64_t m_checks = 0;
+    uint64_t m_detections = 0;
+};
+#endif
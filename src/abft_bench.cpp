@@ -0,0 +1,220 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "abft.h"
+#include "fault_model.h"
+
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+static CryptoContext<DCRTPoly> makeContext(uint32_t multDepth, uint32_t scaleMod, uint32_t firstMod,
+                                           uint32_t ringDim, uint32_t batchSize) {
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(FIXEDMANUAL);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+    return cc;
+}
+
+// Microsegundos promedio de fn sobre reps repeticiones
+template <typename Fn>
+static double timeUs(uint32_t reps, Fn fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < reps; ++i)
+        fn();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps;
+}
+
+// Overhead de los chequeos por (logN, limbs): SwitchFormat, Encrypt y Decrypt con y sin ABFT
+static std::string runBench(const std::vector<uint32_t>& logNs, const std::vector<uint32_t>& limbCounts,
+                            uint32_t scaleMod, uint32_t firstMod, int logMin, int logMax, uint32_t reps) {
+    // Una linea por operacion: logN,limbs,op,us sin chequeo,us con chequeo,overhead
+    std::string rows;
+    for (uint32_t logN : logNs) {
+        for (uint32_t limbs : limbCounts) {
+            uint32_t ringDim = 1 << logN;
+            uint32_t batchSize = ringDim >> 1;
+            auto cc = makeContext(limbs - 1, scaleMod, firstMod, ringDim, batchSize);
+            auto keys = cc->KeyGen();
+            Abft abft;
+            Plaintext ptxt = cc->MakeCKKSPackedPlaintext(uniform_dist(batchSize, logMin, logMax, 1, false));
+            Ciphertext<DCRTPoly> c;
+            AbftSeal seal;
+            abft.encrypt(cc, keys.publicKey, ptxt, c, seal);   // precalcula los pesos
+            DCRTPoly poly = c->GetElements()[0];
+            Plaintext result;
+
+            struct Op { std::string name; double base; double checked; };
+            std::vector<Op> ops = {
+                {"SwitchFormat", timeUs(reps, [&] { poly.SwitchFormat(); }),
+                                 timeUs(reps, [&] { abft.switchFormat(poly); })},
+                {"Encrypt",      timeUs(reps, [&] { c = cc->Encrypt(keys.publicKey, ptxt); }),
+                                 timeUs(reps, [&] { abft.encrypt(cc, keys.publicKey, ptxt, c, seal); })},
+                {"Decrypt",      timeUs(reps, [&] { cc->Decrypt(keys.secretKey, c, &result); }),
+                                 timeUs(reps, [&] { abft.decrypt(cc, keys.secretKey, c, seal, &result); })},
+            };
+            for (const auto& op : ops) {
+                rows.append(std::to_string(logN) + "," + std::to_string(limbs) + "," + op.name + "," +
+                            std::to_string(op.base) + "," + std::to_string(op.checked) + "," +
+                            std::to_string(op.checked / op.base - 1) + "\n");
+                std::cout << "logN " << logN << " limbs " << limbs << " " << op.name << ": "
+                          << op.base << " us -> " << op.checked << " us" << std::endl;
+            }
+        }
+    }
+    return rows;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    std::string mode     = config["abftMode"];
+    uint32_t coeffStep   = std::stoul(config["abftCoeffStep"]);
+    double sdcBits       = std::stod(config["sdcThresholdBits"]);
+    faultmodel::Model model;
+
+    if (!faultmodel::parse(config["faultModel"], model)) {
+        std::cerr << "[ERROR] faultModel desconocido: " << config["faultModel"] << "\n";
+        return 1;
+    }
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_abft/";
+    std::string endFile = "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    std::string rows;
+    std::string outName;
+    if (mode == "bench") {
+        rows = runBench(parseList(config["abftLogN"]), parseList(config["abftLimbs"]), scaleMod, firstMod,
+                        logMin, logMax, std::stoul(config["abftReps"]));
+        outName = "out_abft_bench";
+    }
+    else if (mode == "campaign") {
+        // Cobertura: el mismo barrido (elemento, limb, coeff, bit) que las campañas de
+        // cifrado, el fault entre Encrypt y Decrypt, y el chequeo antes de Decrypt
+        uint32_t batchSize = ringDim >> 1;
+        if(gap>0)
+            batchSize = batchSize >> gap;
+        auto cc = makeContext(RNS_size, scaleMod, firstMod, ringDim, batchSize);
+        auto keys = cc->KeyGen();
+        Abft abft(seed);
+
+        std::vector<double> input = uniform_dist(batchSize, logMin, logMax, seed_input, false);
+        Plaintext ptxt1 = cc->MakeCKKSPackedPlaintext(input);
+        lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+        Ciphertext<DCRTPoly> c;
+        AbftSeal seal;
+        if (!abft.encrypt(cc, keys.publicKey, ptxt1, c, seal)) {
+            std::cerr << "[ERROR] ABFT detecta un fault sin inyectar nada\n";
+            return 1;
+        }
+
+        Plaintext golden_result;
+        cc->Decrypt(keys.secretKey, c, &golden_result);
+        golden_result->SetLength(batchSize);
+        std::vector<double> golden_result_vec = golden_result->GetRealPackedValue();
+        double golden_norm2 = norm2(input, golden_result_vec, batchSize);
+        if (golden_norm2 >= 0.1) {
+            std::cout << "ERROR!!! Norm2: " << golden_norm2 << "  Input/output: " << input << " " << golden_result  << std::endl;
+            return 1;
+        }
+        double noiseFloor = errorMetrics<METRIC_LINF>(input.data(), golden_result_vec.data(), batchSize).linf;
+
+        // Una linea por fault: modelo,elemento,limb,coeff,bit,detectado,outcome,bits perdidos
+        std::string modelName = faultmodel::name(model);
+        std::vector<faultmodel::WordMask> masks;
+        faultmodel::DenseMask dense;
+        Plaintext result_bitFlip;
+        uint64_t counts[2][5] = {};    // [detectado][outcome]
+        for (uint32_t e = 0; e < c->GetElements().size(); ++e) {
+            auto& limbs = c->GetElements()[e].GetAllElements();
+            for (uint32_t limb = 0; limb < limbs.size(); ++limb) {
+                uint64_t* words = reinterpret_cast<uint64_t*>(&limbs[limb][0]);
+                for (uint32_t coeff = 0; coeff < ringDim; coeff += coeffStep) {
+                    for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+                        faultmodel::generate(model, words, ringDim, coeff, bit, masks);
+                        faultmodel::densify(masks, dense);
+                        faultmodel::applyXor(words, dense);
+                        Outcome outcome = Outcome::DECRYPT_FAIL;
+                        ErrorMetrics metrics;
+                        // El chequeo de Abft::decrypt, hecho aparte para tener el
+                        // resultado aunque Decrypt tire excepcion
+                        bool detected = !abft.verify(c, seal);
+                        try {
+                            cc->Decrypt(keys.secretKey, c, &result_bitFlip);
+                            result_bitFlip->SetLength(batchSize);
+                            std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                            metrics = errorMetrics<METRIC_LINF | METRIC_BITS>(
+                                golden_result_vec.data(), result_bitFlip_vec.data(), batchSize, noiseFloor);
+                            outcome = classifyOutcome(metrics, sdcBits);
+                        }
+                        catch (const std::exception& ex) {
+                            // Decode con error enorme
+                            metrics.bitsLost = INFINITY;
+                        }
+                        faultmodel::applyXor(words, dense);
+                        ++counts[detected][static_cast<int>(outcome)];
+                        rows.append(modelName + "," + std::to_string(e) + "," + std::to_string(limb) + "," +
+                                    std::to_string(coeff) + "," + std::to_string(bit) + "," +
+                                    std::to_string(detected) + "," + outcomeName(outcome) + "," +
+                                    std::to_string(metrics.bitsLost) + "\n");
+                    }
+                }
+            }
+        }
+        if (!abft.verify(c, seal))
+            std::cerr << "[ERROR] El cifrado no quedo restaurado\n";
+
+        for (Outcome o : {Outcome::MASKED, Outcome::SDC, Outcome::DECRYPT_FAIL}) {
+            uint64_t total = counts[0][static_cast<int>(o)] + counts[1][static_cast<int>(o)];
+            std::cout << "  " << outcomeName(o) << ": " << counts[1][static_cast<int>(o)] << "/" << total
+                      << " detectados" << std::endl;
+        }
+        outName = "out_abft_campaign";
+    }
+    else {
+        std::cerr << "[ERROR] abftMode tiene que ser bench o campaign\n";
+        return 1;
+    }
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream abftFile(dir_log+outName+endFile);
+    if (!abftFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero de ABFT\n";
+        return 1;
+    }
+    abftFile << rows;
+    abftFile.close();
+    std::cout<< "File of abft is save" << std::endl;
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+namespace asynclog {
+
+namespace {
+
+// Todo lo que toca el handler de señales es atomico o de tamaño fijo
+std::atomic<Ring*> rings[kMaxThreads];
+std::atomic<int> ringCount{0};
+std::atomic<int> outFd{STDOUT_FILENO};
+std::atomic<bool> running{false};
+std::atomic<bool> stopping{false};
+
+const int kCrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM, SIGINT};
+constexpr int kNumCrashSignals = sizeof(kCrashSignals) / sizeof(kCrashSignals[0]);
+struct sigaction previous[kNumCrashSignals];
+
+struct Writer {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;
+    std::once_flag started;
+};
+
+Writer& writer() {
+    static Writer* w = new Writer();   // vive hasta despues de los atexit
+    return *w;
+}
+
+// Vacia lo que haya en el ring con writev (una o dos partes si da la vuelta).
+// La cola avanza despues de escribir: si el proceso muere a la mitad, el
+// handler de crash vuelve a escribir lo pendiente.
+void drain(Ring& ring, int fd) {
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    while (tail != head) {
+        size_t start = tail & (kRingSize - 1);
+        size_t len = head - tail;
+        struct iovec iov[2];
+        int n = 1;
+        iov[0].iov_base = ring.data + start;
+        iov[0].iov_len = std::min(len, kRingSize - start);
+        if (iov[0].iov_len < len) {
+            iov[1].iov_base = ring.data;
+            iov[1].iov_len = len - iov[0].iov_len;
+            n = 2;
+        }
+        ssize_t w = ::writev(fd, iov, n);
+        if (w <= 0)
+            return;   // destino roto: no bloquear la campaña
+        tail += static_cast<uint64_t>(w);
+        ring.tail.store(tail, std::memory_order_release);
+    }
+}
+
+// Un solo consumidor por ring; el handler de crash espera un poco y si no entra saltea el ring
+bool lockRing(Ring& ring, int spins) {
+    for (int i = 0; i < spins || spins < 0; ++i) {
+        bool expected = false;
+        if (ring.draining.compare_exchange_weak(expected, true, std::memory_order_acquire))
+            return true;
+    }
+    return false;
+}
+
+// Sin escritor (despues de stop o ring sin registrar) vacia el mismo productor
+void selfDrain(Ring& ring) {
+    lockRing(ring, -1);
+    drain(ring, outFd.load(std::memory_order_relaxed));
+    ring.draining.store(false, std::memory_order_release);
+}
+
+void drainAll(int spins) {
+    int fd = outFd.load(std::memory_order_relaxed);
+    int n = ringCount.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) {
+        Ring* ring = rings[i].load(std::memory_order_acquire);
+        if (!ring)
+            continue;
+        // Ring tomado por otro (dueño o escritor): se saltea, mejor perder lineas que duplicarlas
+        if (!lockRing(*ring, spins))
+            continue;
+        drain(*ring, fd);
+        ring->draining.store(false, std::memory_order_release);
+    }
+}
+
+void writerLoop() {
+    Writer& w = writer();
+    while (!stopping.load(std::memory_order_acquire)) {
+        drainAll(-1);
+        std::unique_lock<std::mutex> lock(w.mutex);
+        w.wake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+    drainAll(-1);
+}
+
+// Vacia y sigue con el handler que estaba antes (ej. el sigsetjmp de bitflip_serial);
+// si era el default se restaura y se vuelve a levantar la señal
+void crashHandler(int sig, siginfo_t* info, void* ctx) {
+    drainAll(1 << 20);
+    for (int i = 0; i < kNumCrashSignals; ++i) {
+        if (kCrashSignals[i] != sig)
+            continue;
+        const struct sigaction& prev = previous[i];
+        if (prev.sa_flags & SA_SIGINFO) {
+            prev.sa_sigaction(sig, info, ctx);
+            return;
+        }
+        if (prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN) {
+            prev.sa_handler(sig);
+            return;
+        }
+        sigaction(sig, &prev, nullptr);
+        break;
+    }
+    raise(sig);
+}
+
+void installCrashHandlers() {
+    struct sigaction sa{};
+    sa.sa_sigaction = crashHandler;
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&sa.sa_mask);
+    for (int i = 0; i < kNumCrashSignals; ++i)
+        sigaction(kCrashSignals[i], &sa, &previous[i]);
+}
+
+void stopAtExit() {
+    stop();
+}
+
+}  // namespace
+
+bool start(const std::string& path) {
+    bool ok = true;
+    std::call_once(writer().started, [&] {
+        if (!path.empty()) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::cerr << "[ERROR] No pude abrir el log " << path << ", sigo con stdout\n";
+                ok = false;
+            }
+            else
+                outFd.store(fd, std::memory_order_relaxed);
+        }
+        installCrashHandlers();
+        std::atexit(stopAtExit);
+        running.store(true, std::memory_order_release);
+        writer().thread = std::thread(writerLoop);
+    });
+    return ok;
+}
+
+void stop() {
+    Writer& w = writer();
+    if (!running.exchange(false))
+        return;
+    stopping.store(true, std::memory_order_release);
+    w.wake.notify_one();
+    if (w.thread.joinable())
+        w.thread.join();
+    int fd = outFd.load(std::memory_order_relaxed);
+    if (fd != STDOUT_FILENO)
+        ::fsync(fd);
+}
+
+Ring* newRing() {
+    start();   // sin start() explicito el destino es stdout
+    Ring* ring = new Ring();
+    int slot = ringCount.load(std::memory_order_relaxed);
+    while (slot < kMaxThreads &&
+           !ringCount.compare_exchange_weak(slot, slot + 1, std::memory_order_acq_rel))
+        ;
+    if (slot >= kMaxThreads) {
+        std::cerr << "[WARN] async_log: mas de " << kMaxThreads << " hilos, el resto escribe sincronico\n";
+        return ring;
+    }
+    ring->registered = true;
+    rings[slot].store(ring, std::memory_order_release);
+    return ring;
+}
+
+void push(Ring& ring, const char* msg, size_t len) {
+    len = std::min(len, kRingSize - 2);
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    while (kRingSize - (head - ring.tail.load(std::memory_order_acquire)) < len + 1) {
+        if (!running.load(std::memory_order_acquire)) {
+            selfDrain(ring);
+            continue;
+        }
+        writer().wake.notify_one();
+        std::this_thread::yield();
+    }
+    size_t start = head & (kRingSize - 1);
+    size_t first = std::min(len, kRingSize - start);
+    std::memcpy(ring.data + start, msg, first);
+    std::memcpy(ring.data, msg + first, len - first);
+    ring.data[(head + len) & (kRingSize - 1)] = '\n';
+    ring.head.store(head + len + 1, std::memory_order_release);
+    if (!running.load(std::memory_order_acquire) || !ring.registered)
+        selfDrain(ring);
+    else if (head + len + 1 - ring.tail.load(std::memory_order_relaxed) > kRingSize / 2)
+        writer().wake.notify_one();
+}
+
+}  // namespace asynclog
@@ -0,0 +1,104 @@
+#ifndef ASYNC_LOG_MATI_H
+#define ASYNC_LOG_MATI_H
+
+// Logging asincronico para los loops de las campañas.
+//
+//   asynclog::start();                       // stdout; start("x.log") a archivo
+//   LOG_DEBUG("Hex value: 0x" << std::hex << v);
+//   LOG_INFO("Norm2: " << norm);
+//
+// Cada hilo escribe en su propio ring buffer (un productor, un consumidor, sin
+// locks); un hilo escritor los vacia con un writev por tanda. El orden se
+// mantiene dentro de un hilo, no entre hilos ni respecto de std::cout.
+// Si el ring se llena el productor espera al escritor: no se pierden lineas.
+//
+// Los niveles por debajo de ASYNC_LOG_LEVEL (0 trace .. 4 error, por defecto 2)
+// no generan codigo. Al salir (atexit) y con SIGSEGV, SIGBUS, SIGFPE, SIGILL,
+// SIGABRT, SIGTERM o SIGINT se vacian los rings con write(2) antes de seguir
+// con el handler anterior, asi lo ultimo antes de un crash queda escrito.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#ifndef ASYNC_LOG_LEVEL
+#define ASYNC_LOG_LEVEL 2
+#endif
+
+#define ASYNC_LOG_TRACE 0
+#define ASYNC_LOG_DEBUG 1
+#define ASYNC_LOG_INFO  2
+#define ASYNC_LOG_WARN  3
+#define ASYNC_LOG_ERROR 4
+
+namespace asynclog {
+
+constexpr size_t kRingSize = 1 << 20;   // bytes por hilo, potencia de 2
+constexpr int kMaxThreads = 64;
+
+struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};   // escribe el productor
+    alignas(64) std::atomic<uint64_t> tail{0};   // escribe el consumidor
+    alignas(64) std::atomic<bool> draining{false};
+    bool registered = false;                     // lo vacia el escritor
+    std::ostringstream fmt;                      // formato del productor, se reusa
+    char data[kRingSize];
+};
+
+Ring* newRing();
+inline thread_local Ring* tlsRing = nullptr;
+
+inline Ring& localRing() {
+    if (!tlsRing)
+        tlsRing = newRing();
+    return *tlsRing;
+}
+
+// Abre el destino (vacio: stdout) y arranca el hilo escritor
+bool start(const std::string& path = "");
+// Vacia todo y para el escritor; tambien corre en atexit
+void stop();
+// Copia la linea al ring del hilo (agrega '\n')
+void push(Ring& ring, const char* msg, size_t len);
+
+inline void emit(Ring& ring) {
+    std::string s = ring.fmt.str();
+    push(ring, s.data(), s.size());
+    ring.fmt.str(std::string());
+    ring.fmt.flags(std::ios_base::skipws | std::ios_base::dec);   // un std::hex no pasa a la linea siguiente
+}
+
+}  // namespace asynclog
+
+#define ASYNC_LOG_EMIT(msg)                              \
+    do {                                                 \
+        asynclog::Ring& asyncLogRing_ = asynclog::localRing(); \
+        asyncLogRing_.fmt << msg;                        \
+        asynclog::emit(asyncLogRing_);                   \
+    } while (0)
+
+#if ASYNC_LOG_LEVEL <= ASYNC_LOG_TRACE
+#define LOG_TRACE(msg) ASYNC_LOG_EMIT(msg)
+#else
+#define LOG_TRACE(msg) ((void)0)
+#endif
+#if ASYNC_LOG_LEVEL <= ASYNC_LOG_DEBUG
+#define LOG_DEBUG(msg) ASYNC_LOG_EMIT(msg)
+#else
+#define LOG_DEBUG(msg) ((void)0)
+#endif
+#if ASYNC_LOG_LEVEL <= ASYNC_LOG_INFO
+#define LOG_INFO(msg) ASYNC_LOG_EMIT(msg)
+#else
+#define LOG_INFO(msg) ((void)0)
+#endif
+#if ASYNC_LOG_LEVEL <= ASYNC_LOG_WARN
+#define LOG_WARN(msg) ASYNC_LOG_EMIT("[WARN] " << msg)
+#else
+#define LOG_WARN(msg) ((void)0)
+#endif
+#define LOG_ERROR(msg) ASYNC_LOG_EMIT("[ERROR] " << msg)
+
+#endif
@@ -0,0 +1,298 @@
+#include "batch_eval.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Decode tira excepcion si la parte imaginaria tiene desvio mayor a 2^-5 (en unidades del mensaje)
+static const double DECODE_IMAG_LIMIT = 1.0 / 32;
+
+// Bytes de los buffers SoA de un tile (limb, re, im) que queremos mantener en L2
+static const size_t TILE_BYTES = 1 << 20;
+
+// Columnas INTT(e_p) guardadas: N palabras cada una, 4 MB en total con logN=16
+static const size_t COLUMN_SLOTS = 8;
+
+static inline uint64_t mulMod(uint64_t a, uint64_t b, uint64_t q) {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) % q);
+}
+
+BatchEvaluator::BatchEvaluator(const CryptoContext<DCRTPoly>& cc, const PrivateKey<DCRTPoly>& secretKey,
+                               const Ciphertext<DCRTPoly>& golden, Format faultFormat, NormMode mode)
+    : m_format(faultFormat), m_mode(mode) {
+    const auto& elems = golden->GetElements();
+    m_n = elems[0].GetRingDimension();
+    m_limbParams = elems[0].GetParams()->GetParams();
+    size_t numLimbs = m_limbParams.size();
+
+    double logQ = 0;
+    for (const auto& p : m_limbParams) {
+        m_q.push_back(p->GetModulus().ConvertToInt());
+        logQ += std::log2(static_cast<double>(m_q.back()));
+    }
+    uint32_t slots = cc->GetEncodingParams()->GetBatchSize();
+    m_supported = elems.size() == 2 && slots == m_n / 2 && logQ < 126;
+    if (!m_supported)
+        return;
+    m_scale = golden->GetScalingFactor();
+
+    // c0 en el formato en que se aplica el fault
+    DCRTPoly c0 = elems[0];
+    if (c0.GetFormat() != m_format)
+        c0.SetFormat(m_format);
+    m_c0.resize(numLimbs);
+    for (size_t l = 0; l < numLimbs; ++l) {
+        const auto& values = c0.GetElementAtIndex(l).GetValues();
+        m_c0[l].resize(m_n);
+        for (uint32_t i = 0; i < m_n; ++i)
+            m_c0[l][i] = values[i].ConvertToInt();
+    }
+
+    // c0 + c1*s golden, en coeficientes
+    DCRTPoly a = elems[0], b = elems[1];
+    a.SetFormat(Format::EVALUATION);
+    b.SetFormat(Format::EVALUATION);
+    DCRTPoly s = secretKey->GetPrivateElement();
+    if (s.GetNumOfElements() > numLimbs)
+        s.DropLastElements(s.GetNumOfElements() - numLimbs);
+    DCRTPoly m = a + b * s;
+    m.SetFormat(Format::COEFFICIENT);
+    m_m.resize(numLimbs);
+    for (size_t l = 0; l < numLimbs; ++l) {
+        const auto& values = m.GetElementAtIndex(l).GetValues();
+        m_m[l].resize(m_n);
+        for (uint32_t i = 0; i < m_n; ++i)
+            m_m[l][i] = values[i].ConvertToInt();
+    }
+
+    // Constantes CRT: x = sum_l [m_l * (Q/q_l)^-1]_{q_l} * Q/q_l mod Q
+    m_Q = 1;
+    for (uint64_t q : m_q)
+        m_Q *= q;
+    for (uint64_t q : m_q) {
+        u128 qHat = m_Q / q;
+        m_qHat.push_back(qHat);
+        m_qHatInv.push_back(NativeInteger(static_cast<uint64_t>(qHat % q)).ModInverse(NativeInteger(q)).ConvertToInt());
+    }
+    m_x.assign(m_n, 0);
+    for (size_t l = 0; l < numLimbs; ++l) {
+        for (uint32_t i = 0; i < m_n; ++i) {
+            m_x[i] += static_cast<u128>(mulMod(m_m[l][i], m_qHatInv[l], m_q[l])) * m_qHat[l];
+            if (m_x[i] >= m_Q)
+                m_x[i] -= m_Q;
+        }
+    }
+
+    // FFT de largo N: y_t = sum_i (delta_i zeta^i) w^{it}, evalua en las raices 2N-esimas impares
+    m_twRe.resize(m_n / 2);
+    m_twIm.resize(m_n / 2);
+    for (uint32_t j = 0; j < m_n / 2; ++j) {
+        m_twRe[j] = std::cos(2 * M_PI * j / m_n);
+        m_twIm[j] = -std::sin(2 * M_PI * j / m_n);
+    }
+    m_psiRe.resize(m_n);
+    m_psiIm.resize(m_n);
+    for (uint32_t i = 0; i < m_n; ++i) {
+        m_psiRe[i] = std::cos(M_PI * i / m_n);
+        m_psiIm[i] = -std::sin(M_PI * i / m_n);
+    }
+
+    // Tile multiplo de 4 (un registro AVX2 de doubles) que entra en L2
+    m_tile = TILE_BYTES / (static_cast<size_t>(m_n) * 3 * sizeof(double));
+    m_tile = std::min<size_t>(std::max<size_t>(m_tile, 4), 64) & ~static_cast<size_t>(3);
+    m_limbBuf.resize(static_cast<size_t>(m_n) * m_tile);
+    m_re.resize(static_cast<size_t>(m_n) * m_tile);
+    m_im.resize(static_cast<size_t>(m_n) * m_tile);
+    m_columns.resize(COLUMN_SLOTS);
+}
+
+const std::vector<uint64_t>& BatchEvaluator::column(uint32_t limb, uint32_t p) {
+    uint64_t key = (static_cast<uint64_t>(limb) << 32) | p;
+    for (const Column& c : m_columns) {
+        if (c.key == key)
+            return c.values;
+    }
+
+    // Se usa la INTT de OpenFHE para respetar su orden bit-reversed
+    NativePoly unit(m_limbParams[limb], Format::EVALUATION, true);
+    unit[p] = NativeInteger(1);
+    unit.SetFormat(Format::COEFFICIENT);
+    Column& col = m_columns[m_nextColumn];
+    m_nextColumn = (m_nextColumn + 1) % m_columns.size();
+    col.key = key;
+    col.values.resize(m_n);
+    for (uint32_t i = 0; i < m_n; ++i)
+        col.values[i] = unit[i].ConvertToInt();
+    return col.values;
+}
+
+const std::vector<BatchEvaluator::u128>& BatchEvaluator::restOf(uint32_t limb) {
+    auto it = m_rest.find(limb);
+    if (it != m_rest.end())
+        return it->second;
+
+    std::vector<u128>& rest = m_rest[limb];
+    rest.resize(m_n);
+    for (uint32_t i = 0; i < m_n; ++i) {
+        u128 own = static_cast<u128>(mulMod(m_m[limb][i], m_qHatInv[limb], m_q[limb])) * m_qHat[limb];
+        rest[i] = m_x[i] >= own ? m_x[i] - own : m_x[i] + m_Q - own;
+    }
+    return rest;
+}
+
+void BatchEvaluator::evaluate(const std::vector<BatchFault>& faults, std::vector<double>& norms) {
+    norms.assign(faults.size(), INFINITY);
+    if (!m_supported)
+        return;
+    for (size_t off = 0; off < faults.size(); off += m_tile)
+        evaluateTile(&faults[off], std::min(m_tile, faults.size() - off), &norms[off]);
+}
+
+void BatchEvaluator::evaluateTile(const BatchFault* faults, size_t count, double* norms) {
+    const size_t T = m_tile;
+    const uint32_t N = m_n;
+
+    // 1. Limb perturbado en coeficientes: m'_l = m_l + delta mod q_l (SoA [i][k])
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t l = faults[k].limb;
+        uint64_t q = m_q[l];
+        for (uint32_t i = 0; i < N; ++i)
+            m_limbBuf[i * T + k] = m_m[l][i];
+
+        for (const auto& wm : faults[k].masks) {
+            uint64_t orig = m_c0[l][wm.word];
+            uint64_t bad  = (orig ^ wm.mask) % q;
+            uint64_t diff = bad >= orig ? bad - orig : bad + q - orig;
+            if (diff == 0)
+                continue;
+            if (m_format == Format::COEFFICIENT) {
+                uint64_t& v = m_limbBuf[wm.word * T + k];
+                v = v + diff >= q ? v + diff - q : v + diff;
+                continue;
+            }
+            const std::vector<uint64_t>& col = column(l, static_cast<uint32_t>(wm.word));
+            for (uint32_t i = 0; i < N; ++i) {
+                uint64_t d = mulMod(diff, col[i], q);
+                uint64_t& v = m_limbBuf[i * T + k];
+                v = v + d >= q ? v + d - q : v + d;
+            }
+        }
+    }
+
+    // 2. CRT a Z_Q, centrado y diferencia con el golden: error e_i en unidades del mensaje
+    const u128 halfQ = m_Q >> 1;
+    std::vector<const u128*> rest(count);
+    for (size_t k = 0; k < count; ++k)
+        rest[k] = restOf(faults[k].limb).data();
+
+    for (uint32_t i = 0; i < N; ++i) {
+        i128 golden = m_x[i] > halfQ ? static_cast<i128>(m_x[i]) - static_cast<i128>(m_Q) : static_cast<i128>(m_x[i]);
+        double* re = &m_re[i * T];
+        for (size_t k = 0; k < count; ++k) {
+            uint32_t l = faults[k].limb;
+            u128 x = rest[k][i] + static_cast<u128>(mulMod(m_limbBuf[i * T + k], m_qHatInv[l], m_q[l])) * m_qHat[l];
+            if (x >= m_Q)
+                x -= m_Q;
+            i128 centered = x > halfQ ? static_cast<i128>(x) - static_cast<i128>(m_Q) : static_cast<i128>(x);
+            re[k] = static_cast<double>(centered - golden) / m_scale;
+        }
+        for (size_t k = count; k < T; ++k)
+            re[k] = 0;
+    }
+
+    if (m_mode == NormMode::COEFF)
+        coeffNorms(count, norms);
+    else
+        decodeNorms(count, norms);
+}
+
+// Sin decode: Parseval sobre las N raices impares y sum_t y_t^2 = N (e^2)_0 - N (e^2)_N
+void BatchEvaluator::coeffNorms(size_t count, double* norms) {
+    const size_t T = m_tile;
+    const uint32_t N = m_n;
+    std::vector<double> sq(T, 0), cross(T, 0);
+    for (uint32_t i = 0; i < N; ++i) {
+        const double* e = &m_re[i * T];
+        const double* mirror = &m_re[((N - i) % N) * T];
+        double* c = cross.data();
+        double* s2 = sq.data();
+        for (size_t k = 0; k < T; ++k) {
+            s2[k] += e[k] * e[k];
+            c[k]  += e[k] * mirror[k];
+        }
+    }
+    // i = 0 se cuenta con su propio espejo en cross, va al otro lado de la suma
+    const double* e0 = &m_re[0];
+    for (size_t k = 0; k < count; ++k) {
+        double c = cross[k] - e0[k] * e0[k];
+        // Promedios sobre los N/2 slots de Re(z)^2 e Im(z)^2
+        double meanRe = 0.5 * (sq[k] + e0[k] * e0[k] - c);
+        double meanIm = 0.5 * (sq[k] - e0[k] * e0[k] + c);
+        double imagStd = std::sqrt(std::max(meanIm, 0.0));
+        norms[k] = imagStd > DECODE_IMAG_LIMIT ? INFINITY : std::sqrt(std::max(meanRe, 0.0));
+    }
+}
+
+void BatchEvaluator::decodeNorms(size_t count, double* norms) {
+    const size_t T = m_tile;
+    const uint32_t N = m_n;
+
+    // Giro negaciclico por zeta^i
+    for (uint32_t i = 0; i < N; ++i) {
+        double* re = &m_re[i * T];
+        double* im = &m_im[i * T];
+        for (size_t k = 0; k < T; ++k) {
+            im[k] = re[k] * m_psiIm[i];
+            re[k] = re[k] * m_psiRe[i];
+        }
+    }
+
+    // FFT radix-2 sobre i; todas las mariposas recorren k contiguo
+    for (uint32_t i = 1, j = 0; i < N; ++i) {
+        uint32_t bit = N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            std::swap_ranges(&m_re[i * T], &m_re[i * T] + T, &m_re[j * T]);
+            std::swap_ranges(&m_im[i * T], &m_im[i * T] + T, &m_im[j * T]);
+        }
+    }
+    for (uint32_t len = 2; len <= N; len <<= 1) {
+        uint32_t half = len >> 1;
+        uint32_t step = N / len;
+        for (uint32_t start = 0; start < N; start += len) {
+            for (uint32_t j = 0; j < half; ++j) {
+                const double wr = m_twRe[j * step];
+                const double wi = m_twIm[j * step];
+                double* __restrict ar = &m_re[(start + j) * T];
+                double* __restrict ai = &m_im[(start + j) * T];
+                double* __restrict br = &m_re[(start + j + half) * T];
+                double* __restrict bi = &m_im[(start + j + half) * T];
+                for (size_t k = 0; k < T; ++k) {
+                    double tr = br[k] * wr - bi[k] * wi;
+                    double ti = br[k] * wi + bi[k] * wr;
+                    br[k] = ar[k] - tr;
+                    bi[k] = ai[k] - ti;
+                    ar[k] += tr;
+                    ai[k] += ti;
+                }
+            }
+        }
+    }
+
+    // Cada slot y su conjugado aparecen una vez entre los N puntos:
+    //    sum_slots Re(z)^2 = sum_t Re(y_t)^2 / 2, y hay N/2 slots
+    std::vector<double> sumRe(T, 0), sumIm(T, 0);
+    for (uint32_t t = 0; t < N; ++t) {
+        const double* re = &m_re[t * T];
+        const double* im = &m_im[t * T];
+        for (size_t k = 0; k < T; ++k) {
+            sumRe[k] += re[k] * re[k];
+            sumIm[k] += im[k] * im[k];
+        }
+    }
+    for (size_t k = 0; k < count; ++k) {
+        double imagStd = std::sqrt(sumIm[k] / N);
+        norms[k] = imagStd > DECODE_IMAG_LIMIT ? INFINITY : std::sqrt(sumRe[k] / N);
+    }
+}
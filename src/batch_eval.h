@@ -0,0 +1,94 @@
+#ifndef BATCH_EVAL_MATI_H
+#define BATCH_EVAL_MATI_H
+
+#include "openfhe.h"
+#include "fault_model.h"
+
+#include <vector>
+#include <unordered_map>
+using namespace lbcrypto;
+
+// Un fault sobre c0 del cifrado golden: mascaras XOR sobre las palabras de un limb.
+struct BatchFault {
+    uint32_t limb;
+    std::vector<faultmodel::WordMask> masks;
+};
+
+// Evalua K faults contra el mismo cifrado golden sin llamar a Decrypt K veces.
+// Decrypt es lineal en c0, asi que solo hace falta el delta de cada fault:
+//   1. delta en coeficientes del limb atacado (si el fault es en EVAL se usa la
+//      columna INTT(e_p); se guardan solo las ultimas, un barrido repite la
+//      misma p en los 64 bits de un coeficiente y multi:w usa w seguidas)
+//   2. suma modular con (c0 + c1*s) golden y CRT a Z_Q en __int128
+//   3. decode de la diferencia centrada con una FFT negaciclica
+// Los K faults viven en buffers SoA [coef][k], el loop interno es sobre k y
+// vectoriza. K se procesa en tiles para que el buffer entre en L2.
+//
+// Con slots completos el embedding canonico es una isometria escalada y la
+// norma sale exacta del polinomio de error e (NormMode::COEFF, O(N)):
+//   sum_slots Re(z_j)^2 = N/4 * (sum_i e_i^2 + e_0^2 - sum_{i>0} e_i e_{N-i})
+// NormMode::DECODE hace la FFT completa, queda para validar.
+//
+// Diferencias con Decrypt: los valores corruptos se reducen mod q (OpenFHE no
+// reduce antes de la NTT) y no se suma el ruido gaussiano de Decode. Decode
+// tira excepcion con error imaginario grande; aca se devuelve INFINITY.
+enum class NormMode { COEFF, DECODE };
+
+class BatchEvaluator {
+public:
+    // faultFormat: formato en el que esta c0 cuando se aplica el fault
+    BatchEvaluator(const CryptoContext<DCRTPoly>& cc, const PrivateKey<DCRTPoly>& secretKey,
+                   const Ciphertext<DCRTPoly>& golden, Format faultFormat = Format::EVALUATION,
+                   NormMode mode = NormMode::COEFF);
+
+    // Slots completos (gap = 0) y Q < 2^126; si no, usar Decrypt
+    bool supported() const { return m_supported; }
+
+    // norms[k] = norm2(golden, faulty_k) sobre los N/2 slots
+    void evaluate(const std::vector<BatchFault>& faults, std::vector<double>& norms);
+
+    // Palabras de c0 en el formato del fault, para generar mascaras (stuck-at)
+    const uint64_t* pristine(uint32_t limb) const { return m_c0[limb].data(); }
+    uint32_t ringDim() const { return m_n; }
+
+private:
+    using u128 = unsigned __int128;
+    using i128 = __int128;
+
+    const std::vector<uint64_t>& column(uint32_t limb, uint32_t p);
+    const std::vector<u128>& restOf(uint32_t limb);
+    void evaluateTile(const BatchFault* faults, size_t count, double* norms);
+    void coeffNorms(size_t count, double* norms);
+    void decodeNorms(size_t count, double* norms);
+
+    bool m_supported = false;
+    uint32_t m_n = 0;
+    Format m_format;
+    NormMode m_mode;
+    double m_scale = 1;
+    std::vector<std::shared_ptr<ILNativeParams>> m_limbParams;
+    std::vector<uint64_t> m_q;
+    std::vector<uint64_t> m_qHatInv;               // [(Q/q_l)^-1]_{q_l}
+    std::vector<u128> m_qHat;                      // Q/q_l
+    u128 m_Q = 0;
+
+    std::vector<std::vector<uint64_t>> m_c0;       // c0 golden en m_format
+    std::vector<std::vector<uint64_t>> m_m;        // (c0 + c1*s) golden en coeficientes
+    std::vector<u128> m_x;                         // CRT golden en [0, Q)
+    std::unordered_map<uint32_t, std::vector<u128>> m_rest;          // m_x sin el aporte del limb
+    // INTT(e_p) de los ultimos (limb, p), reemplazo round-robin
+    struct Column {
+        uint64_t key = ~0ULL;
+        std::vector<uint64_t> values;
+    };
+    std::vector<Column> m_columns;
+    size_t m_nextColumn = 0;
+
+    // Buffers SoA del tile, indexados [i * tile + k]; m_re guarda el error e antes de la FFT
+    size_t m_tile = 0;
+    std::vector<uint64_t> m_limbBuf;
+    std::vector<double> m_re, m_im;
+    std::vector<double> m_twRe, m_twIm;            // raices N-esimas para la FFT
+    std::vector<double> m_psiRe, m_psiIm;          // zeta^i, giro negaciclico
+};
+#endif
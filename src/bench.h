@@ -0,0 +1,103 @@
+#ifndef BENCH_MATI_H
+#define BENCH_MATI_H
+
+// Harness de benchmarks: warm-up, N muestras por caso, estadisticos por
+// percentil y salida JSON para comparar entre versiones de OpenFHE.
+//
+//   BenchRunner runner(warmup, reps);
+//   runner.run("Encrypt", {{"logN", "12"}}, [&] { cc->Encrypt(pk, ptxt); });
+//   out << runner.json();
+//
+// Los tiempos son por llamada, en microsegundos.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef OPENFHE_VERSION_STR
+#define OPENFHE_VERSION_STR "unknown"
+#endif
+
+using BenchParams = std::vector<std::pair<std::string, std::string>>;
+
+struct BenchStats {
+    std::string name;
+    BenchParams params;
+    size_t samples = 0;
+    double min = 0, median = 0, p90 = 0, p99 = 0, max = 0, mean = 0;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(uint32_t warmup, uint32_t reps) : m_warmup(warmup), m_reps(reps ? reps : 1) {}
+
+    template <typename Fn>
+    const BenchStats& run(const std::string& name, const BenchParams& params, Fn fn) {
+        for (uint32_t i = 0; i < m_warmup; ++i)
+            fn();
+        std::vector<double> us(m_reps);
+        for (uint32_t i = 0; i < m_reps; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        }
+        m_results.push_back(summarize(name, params, us));
+        return m_results.back();
+    }
+
+    const std::vector<BenchStats>& results() const { return m_results; }
+
+    std::string json() const {
+        std::string out = "{\n  \"openfhe\": \"" OPENFHE_VERSION_STR "\",\n  \"unit\": \"us\",\n  \"results\": [\n";
+        for (size_t r = 0; r < m_results.size(); ++r) {
+            const BenchStats& s = m_results[r];
+            out += "    {\"name\": \"" + s.name + "\", \"params\": {";
+            for (size_t p = 0; p < s.params.size(); ++p)
+                out += (p ? ", \"" : "\"") + s.params[p].first + "\": " + s.params[p].second;
+            out += "}, \"samples\": " + std::to_string(s.samples) + ", \"min\": " + number(s.min) +
+                   ", \"median\": " + number(s.median) + ", \"p90\": " + number(s.p90) +
+                   ", \"p99\": " + number(s.p99) + ", \"max\": " + number(s.max) +
+                   ", \"mean\": " + number(s.mean) + "}" + (r + 1 < m_results.size() ? ",\n" : "\n");
+        }
+        return out + "  ]\n}\n";
+    }
+
+private:
+    // Percentil nearest-rank sobre las muestras ordenadas
+    static double percentile(const std::vector<double>& sorted, double p) {
+        size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+
+    static BenchStats summarize(const std::string& name, const BenchParams& params, std::vector<double>& us) {
+        std::sort(us.begin(), us.end());
+        BenchStats s;
+        s.name = name;
+        s.params = params;
+        s.samples = us.size();
+        s.min = us.front();
+        s.max = us.back();
+        s.median = percentile(us, 0.5);
+        s.p90 = percentile(us, 0.9);
+        s.p99 = percentile(us, 0.99);
+        for (double v : us)
+            s.mean += v;
+        s.mean /= us.size();
+        return s;
+    }
+
+    static std::string number(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3f", v);
+        return buf;
+    }
+
+    uint32_t m_warmup;
+    uint32_t m_reps;
+    std::vector<BenchStats> m_results;
+};
+#endif
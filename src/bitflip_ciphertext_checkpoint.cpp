@@ -1,5 +1,11 @@
 #include "openfhe.h"
 #include "utils.h"
+#include "fault_model.h"
+#include "batch_eval.h"
+#include "abft.h"
+#include "phase_timer.h"
+#include "async_log.h"
+#include "fault_stats.h"
 #include <unistd.h>
 
 
@@ -25,6 +31,81 @@ asm(
 
 namespace fs = std::filesystem;
 
+// Destino de cada norma: filas de texto (exacto) y/o el agregador en linea
+struct NormSink {
+    std::string* rows;    // nullptr con faultStats=1 y faultStatsExact=0
+    FaultStats* stats;    // nullptr con faultStats=0
+    double noiseFloor;    // norm2 del golden contra el input
+    double sdcBits;
+};
+
+// Sin norma finita el Decrypt no sirvio; si no, SDC segun los bits perdidos sobre el piso
+static Outcome normOutcome(double norm, const NormSink& sink) {
+    if (!std::isfinite(norm))
+        return Outcome::DECRYPT_FAIL;
+    ErrorMetrics metrics;
+    metrics.rms = norm;
+    metrics.bitsLost = bitsLost(norm, sink.noiseFloor);
+    return classifyOutcome(metrics, sink.sdcBits);
+}
+
+static void flushBatch(BatchEvaluator& evaluator, const std::string& modelName, std::vector<BatchFault>& faults,
+                       std::vector<std::pair<uint32_t, uint32_t>>& sites, NormSink& sink) {
+    std::vector<double> norms;
+    {
+        PHASE_SCOPE("batch_evaluate");
+        evaluator.evaluate(faults, norms);
+    }
+    PHASE_COUNT("faults", faults.size());
+    PHASE_SCOPE("append");
+    for (size_t k = 0; k < faults.size(); ++k) {
+        if (sink.stats)
+            sink.stats->add(0, 0, sites[k].first, sites[k].second, norms[k], normOutcome(norms[k], sink));
+        if (sink.rows)
+            sink.rows->append(modelName + "," + std::to_string(sites[k].first) + "," + std::to_string(sites[k].second) +
+                              "," + std::to_string(norms[k]) + "\n");
+    }
+    faults.clear();
+    sites.clear();
+}
+
+// Mismo barrido (coeff, bit) sobre c0 limb 0 que pintool_BitFlip_checkpoint, pero
+// sin PIN: los faults se evaluan de a batchK con BatchEvaluator.
+static void runBatchCampaign(BatchEvaluator& evaluator, const faultmodel::Model& model, uint32_t batchK,
+                             const std::string& modelName, NormSink& sink) {
+    std::vector<BatchFault> faults;
+    std::vector<std::pair<uint32_t, uint32_t>> sites;
+    std::vector<faultmodel::Site> pending;
+    std::vector<faultmodel::WordMask> masks;
+    std::vector<uint32_t> offsets;
+    faults.reserve(batchK);
+    sites.reserve(batchK);
+    pending.reserve(batchK);
+    // Las mascaras del batch salen de una sola llamada, despues se reparten por fault
+    auto generateAndFlush = [&]() {
+        {
+            PHASE_SCOPE("batch_generate");
+            faultmodel::generateBatch(model, evaluator.pristine(0), evaluator.ringDim(), pending.data(),
+                                      pending.size(), masks, offsets);
+            for (size_t k = 0; k < pending.size(); ++k)
+                faults.push_back({0, std::vector<faultmodel::WordMask>(masks.begin() + offsets[k],
+                                                                       masks.begin() + offsets[k + 1])});
+        }
+        pending.clear();
+        flushBatch(evaluator, modelName, faults, sites, sink);
+    };
+    for (uint32_t coeff = 0; coeff < evaluator.ringDim(); ++coeff) {
+        for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+            pending.push_back({coeff, bit});
+            sites.emplace_back(coeff, bit);
+            if (pending.size() == batchK)
+                generateAndFlush();
+        }
+    }
+    if (!pending.empty())
+        generateAndFlush();
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 3) {
         std::cerr << "Need number of seeds and number seeds input \n";
@@ -45,6 +126,29 @@ int main(int argc, char* argv[]) {
     uint32_t gap         = std::stoul(config["gap"]);
     int logMin           = std::stoi(config["logMin"]);
     int logMax           = std::stoi(config["logMax"]);
+    // Va en la tercera linea de target_address.txt: el pintool corta si su -fault_model no coincide
+    faultmodel::Model model;
+    if (!faultmodel::parse(config["faultModel"], model)) {
+        std::cerr << "[ERROR] faultModel desconocido: " << config["faultModel"] << "\n";
+        return 1;
+    }
+    std::string modelName = faultmodel::name(model);
+    // batchEval=K > 0 evalua los faults de a K sin PIN (solo gap=0)
+    uint32_t batchK      = std::stoul(config["batchEval"]);
+    // normMode=coeff saca la norma del polinomio de error sin decode, decode hace la FFT.
+    // Solo aplica con batchEval > 0: el loop con Decrypt siempre mide despues del decode
+    NormMode normMode    = config["normMode"] == "decode" ? NormMode::DECODE : NormMode::COEFF;
+    if (batchK == 0 && config["normMode"] == "coeff")
+        std::cerr << "[WARN] normMode=coeff solo aplica con batchEval>0, con Decrypt la norma sale del decode\n";
+    // abftCheck=1 verifica el checksum ABFT antes de cada Decrypt y agrega la columna detectado
+    bool abftCheck       = std::stoi(config["abftCheck"]);
+    // faultStats=1 agrega en linea (histogramas por bit, outcomes por coeff) a log_stats/;
+    // faultStatsExact=1 ademas guarda la norma de cada fault en log_norm2/ como siempre
+    bool faultStats      = std::stoi(config["faultStats"]);
+    bool faultStatsExact = std::stoi(config["faultStatsExact"]);
+    // Rangos de coeficientes en out_stats_coeff, 0 = uno por coeficiente
+    uint32_t statsCoeffCells = std::stoul(config["faultStatsCoeffCells"]);
+    double sdcBits       = std::stod(config["sdcThresholdBits"]);
 
 
         // TODO: arreglar este path
@@ -55,6 +159,8 @@ int main(int argc, char* argv[]) {
     std::cout << info << std::endl;
     std::string dir_log = prelog + info;
     std::string endFile = "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+    // Con -DPHASE_TIMERS: JSON con el histograma de cada fase al salir y con kill -USR1
+    PHASE_INSTALL(dir_log + "log_phases/phases_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".json");
 
 
     uint32_t multDepth = RNS_size;
@@ -97,43 +203,111 @@ int main(int argc, char* argv[]) {
         Plaintext result_bitFlip;
         double norm2_abs = 0;
         std::string norms2;
-        norms2.reserve(ringDim * 64 * 20); // aprox. 20 chars por entrada
-        c = cc->Encrypt(keys.publicKey, ptxt1);
-        // solo para poder tener a mano el symbolo
-        c->GetElements()[0].SwitchFormat();
-        c->GetElements()[0].SwitchFormat();
-        auto raw_ctxt = c.get();
-        auto& c_elem_ptr = raw_ctxt->GetElements()[0].GetAllElements()[0][0];
-
-        std::ofstream ofs(path + "pintools/bitflips/target_address.txt");
-        ofs << std::hex << reinterpret_cast<uintptr_t>(&(raw_ctxt->GetElements()[0]))<< "\n";
-        ofs << std::hex << reinterpret_cast<uintptr_t>(&c_elem_ptr)<< "\n";
-        ofs.close();
-        addr_label();
-
-        for (int coeff = 0; coeff < ringDim; ++coeff) {
-            std::cout << std::hex << static_cast<uint64_t>(c->GetElements()[0].GetAllElements()[0][coeff]) << std::endl;
+        bool keepRows = !faultStats || faultStatsExact;
+        if (keepRows)
+            norms2.reserve(ringDim * 64 * 20); // aprox. 20 chars por entrada
+        // Forma completa del ciphertext aunque hoy solo se inyecte en c0 limb 0,
+        // asi los .bin de otras campañas con la misma config se mezclan
+        FaultStats stats;
+        if (faultStats)
+            stats = FaultStats(c->GetElements().size(), c->GetElements()[0].GetNumOfElements(), ringDim, statsCoeffCells);
+        NormSink sink{keepRows ? &norms2 : nullptr, faultStats ? &stats : nullptr, golden_norm2, sdcBits};
+        bool batched = false;
+        if (batchK > 0) {
+            // withNTT=1: el pintool hace SwitchFormat alrededor del flip, el fault es en coeficientes
+            BatchEvaluator evaluator(cc, keys.secretKey, c, withNTT ? Format::COEFFICIENT : Format::EVALUATION, normMode);
+            if (evaluator.supported()) {
+                runBatchCampaign(evaluator, model, batchK, modelName, sink);
+                batched = true;
+            }
+            else
+                std::cerr << "[WARN] batchEval necesita gap=0 y Q < 2^126, sigo con Decrypt (decode completo)\n";
         }
+        if (!batched) {
+            c = cc->Encrypt(keys.publicKey, ptxt1);
+            // solo para poder tener a mano el symbolo
+            c->GetElements()[0].SwitchFormat();
+            c->GetElements()[0].SwitchFormat();
+            auto raw_ctxt = c.get();
+            auto& c_elem_ptr = raw_ctxt->GetElements()[0].GetAllElements()[0][0];
+
+            std::ofstream ofs(path + "pintools/bitflips/target_address.txt");
+            ofs << std::hex << reinterpret_cast<uintptr_t>(&(raw_ctxt->GetElements()[0]))<< "\n";
+            ofs << std::hex << reinterpret_cast<uintptr_t>(&c_elem_ptr)<< "\n";
+            ofs << modelName << "\n";
+            ofs.close();
+            addr_label();
+
+            for (int coeff = 0; coeff < ringDim; ++coeff) {
+                LOG_DEBUG(std::hex << static_cast<uint64_t>(c->GetElements()[0].GetAllElements()[0][coeff]));
+            }
+            Abft abft(seed);
+            AbftSeal seal = abft.seal(c);
 
-        for (int coeff = 0; coeff < ringDim; ++coeff) {
-            for (int bit = 0; bit < 64; ++bit) {
-                auto val = c->GetElements()[0].GetAllElements()[0][coeff];
-                uint64_t intVal = val.ConvertToInt();  // puede lanzar si overflowea
-                std::cout << "Hex value: 0x" << std::hex << intVal << std::dec << std::endl;
-                std::cout << "A" << std::endl << std::flush;
-                testVoid();
-                std::cout << "B" << std::endl << std::flush;
-                auto val2 = c->GetElements()[0].GetAllElements()[0][coeff];
-                uint64_t intVal2 = val.ConvertToInt();  // puede lanzar si overflowea
-                std::cout << "Hex value: 0x" << std::hex << intVal << std::dec << std::endl;
-                cc->Decrypt(keys.secretKey, c, &result_bitFlip);
-                result_bitFlip->SetLength(batchSize);
-                std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
-
-                norm2_abs = norm2(golden_result_vec, result_bitFlip_vec, batchSize);
-                norms2.append(std::to_string(norm2_abs)+ ", ");
-                std::cout << "Norm2: " << norm2_abs << std::endl;
-                sync_marker();
+            for (int coeff = 0; coeff < ringDim; ++coeff) {
+                for (int bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+                    PHASE_SCOPE("fault");
+                    {
+                        // Solo para el log: con ASYNC_LOG_LEVEL > debug no se lee la palabra
+                        PHASE_SCOPE("log");
+                        LOG_DEBUG("Hex value: 0x" << std::hex
+                                  << c->GetElements()[0].GetAllElements()[0][coeff].ConvertToInt() << std::dec);
+                        LOG_DEBUG("A");
+                    }
+                    {
+                        // Bajo PIN: flip (y SwitchFormat con withNTT) en el pintool
+                        PHASE_SCOPE("inject");
+                        testVoid();
+                    }
+                    {
+                        PHASE_SCOPE("log");
+                        LOG_DEBUG("B");
+                    }
+                    {
+                        PHASE_SCOPE("log");
+                        LOG_DEBUG("Hex value: 0x" << std::hex
+                                  << c->GetElements()[0].GetAllElements()[0][coeff].ConvertToInt() << std::dec);
+                    }
+                    bool detected = false;
+                    if (abftCheck) {
+                        PHASE_SCOPE("abft");
+                        detected = !abft.verify(c, seal);
+                    }
+                    {
+                        PHASE_SCOPE("decrypt");
+                        cc->Decrypt(keys.secretKey, c, &result_bitFlip);
+                        result_bitFlip->SetLength(batchSize);
+                    }
+                    std::vector<double> result_bitFlip_vec;
+                    {
+                        PHASE_SCOPE("get_real_packed");
+                        result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                    }
+                    {
+                        PHASE_SCOPE("norm2");
+                        norm2_abs = norm2(golden_result_vec, result_bitFlip_vec, batchSize);
+                    }
+                    {
+                        PHASE_SCOPE("append");
+                        if (faultStats)
+                            stats.add(0, 0, coeff, bit, norm2_abs, normOutcome(norm2_abs, sink));
+                        if (keepRows) {
+                            norms2.append(modelName + "," + std::to_string(coeff) + "," + std::to_string(bit) + "," +
+                                          std::to_string(norm2_abs));
+                            norms2.append(abftCheck ? "," + std::to_string(detected) + "\n" : "\n");
+                        }
+                    }
+                    {
+                        PHASE_SCOPE("log");
+                        LOG_INFO("Norm2: " << norm2_abs);
+                    }
+                    {
+                        // Bajo PIN: restore del checkpoint en el pintool
+                        PHASE_SCOPE("restore");
+                        sync_marker();
+                    }
+                    PHASE_COUNT("faults", 1);
+                }
             }
         }
         if (!fs::exists(dir_log)) {
@@ -148,15 +322,38 @@ int main(int argc, char* argv[]) {
                     return 1;
             }
         }
-        std::ofstream norm2File(dir_log+"log_norm2/out_norm2"+endFile);
-        if (!norm2File) {
-          std::cerr << "[ERROR] No pude abrir el fichero de normas\n";
-          return 1;
+        if (keepRows) {
+            std::ofstream norm2File(dir_log+"log_norm2/out_norm2"+endFile);
+            if (!norm2File) {
+              std::cerr << "[ERROR] No pude abrir el fichero de normas\n";
+              return 1;
+            }
+            std::cout<< "File of norm2 is save" << std::endl;
+            norm2File << norms2;
+            norm2File.flush();
+            norm2File.close();
+        }
+        if (faultStats) {
+            std::string dir_stats = dir_log + "log_stats/";
+            if (!fs::exists(dir_stats) && !fs::create_directories(dir_stats)) {
+                std::cerr << "[ERROR] No se pudo crear el directorio\n";
+                return 1;
+            }
+            std::string endStats = "_" + std::to_string(seed) + "_" + std::to_string(seed_input);
+            if (!stats.save(dir_stats + "stats" + endStats + ".bin")) {
+                std::cerr << "[ERROR] No pude guardar las estadisticas\n";
+                return 1;
+            }
+            std::ofstream bitsFile(dir_stats + "out_stats_bits" + endFile);
+            std::ofstream coeffFile(dir_stats + "out_stats_coeff" + endFile);
+            if (!bitsFile || !coeffFile) {
+                std::cerr << "[ERROR] No pude abrir el fichero de estadisticas\n";
+                return 1;
+            }
+            bitsFile << stats.bitRows();
+            coeffFile << stats.coeffRows();
+            std::cout << "File of stats is save" << std::endl;
         }
-        std::cout<< "File of norm2 is save" << std::endl;
-        norm2File << norms2;
-        norm2File.flush();
-        norm2File.close();
 
     }
     else
@@ -0,0 +1,131 @@
+#include "openfhe.h"
+#include "utils.h"
+
+extern "C" void sync_marker();
+asm(
+    ".global sync_marker       \n"
+    ".type   sync_marker, @function \n"
+    "sync_marker:              \n"
+    "    nop                   \n"
+    "    ret                   \n"
+);
+
+extern "C" void addr_label();
+asm(
+    ".global addr_label       \n"
+    ".type   addr_label, @function \n"
+    "addr_label:              \n"
+    "    nop                 \n"
+    "    ret                 \n"
+);
+
+namespace fs = std::filesystem;
+
+// Campaña sobre la FFT en doubles de encode/decode (pintool_BitFlip_fft.so).
+// Cada iteracion es un encode y/o decode completo seguido de sync_marker, PIN
+// avanza al siguiente (sitio, bit). fftStage=decode reusa el cifrado golden
+// y solo desencripta, asi no se paga el encode en cada fault.
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    std::string fftStage = config["fftStage"];
+    uint32_t iterations  = std::stoul(config["fftIterations"]);
+    bool doEncode = fftStage != "decode";
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_fft/";
+    std::string endFile = "_" + fftStage + "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    uint32_t multDepth = RNS_size;
+    uint32_t batchSize = ringDim >> 1;
+    if(gap>0)
+        batchSize = batchSize >> gap;
+    ScalingTechnique rescaleTech = FIXEDMANUAL;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(rescaleTech);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+
+    auto keys = cc->KeyGen();
+
+    std::vector<double> input = uniform_dist(batchSize, logMin, logMax, seed_input, false);
+    Plaintext ptxt1 = cc->MakeCKKSPackedPlaintext(input);
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+    auto c = cc->Encrypt(keys.publicKey, ptxt1);
+
+    Plaintext golden_result;
+    cc->Decrypt(keys.secretKey, c, &golden_result);
+    golden_result->SetLength(batchSize);
+    std::vector<double> golden_result_vec = golden_result->GetRealPackedValue();
+    double golden_norm2 = norm2(input, golden_result_vec, batchSize);
+    if (golden_norm2 >= 0.1) {
+        std::cout << "ERROR!!! Norm2: " << golden_norm2 << "  Input/output: " << input << " " << golden_result  << std::endl;
+        return 1;
+    }
+
+    std::string norms2;
+    norms2.reserve(iterations * 20);
+    Plaintext result_bitFlip;
+    addr_label();
+    for (uint32_t it = 0; it < iterations; ++it) {
+        double norm2_abs = INFINITY;
+        try {
+            auto c_it = c;
+            if (doEncode) {
+                Plaintext ptxt = cc->MakeCKKSPackedPlaintext(input);
+                lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+                c_it = cc->Encrypt(keys.publicKey, ptxt);
+            }
+            cc->Decrypt(keys.secretKey, c_it, &result_bitFlip);
+            result_bitFlip->SetLength(batchSize);
+            std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+            norm2_abs = norm2(golden_result_vec, result_bitFlip_vec, batchSize);
+        }
+        catch (const std::exception& e) {
+            // Decode tira excepcion cuando el error de aproximacion es muy grande
+        }
+        norms2.append(std::to_string(norm2_abs) + ", ");
+        sync_marker();
+    }
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream norm2File(dir_log+"out_norm2"+endFile);
+    if (!norm2File) {
+        std::cerr << "[ERROR] No pude abrir el fichero de normas\n";
+        return 1;
+    }
+    norm2File << norms2;
+    norm2File.close();
+    std::cout<< "File of norm2 is save" << std::endl;
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "fault_targets.h"
+
+namespace fs = std::filesystem;
+
+// Resultado de correr el batch de operaciones con (o sin) una clave corrupta.
+struct BatchResult {
+    std::vector<std::vector<double>> outputs;
+    bool exception = false;
+};
+
+// Cada operacion usa todas las claves: Encrypt (publicKey), EvalMult contra
+// un cifrado de unos + Rescale (relinKey), EvalRotate (rotationKey) y Decrypt
+// (secretKey). El fault se aplica una vez y se amortiza sobre todo el batch.
+static BatchResult runBatch(CryptoContext<DCRTPoly>& cc, const KeyPair<DCRTPoly>& keys,
+                            const std::vector<Plaintext>& ptxts, const Ciphertext<DCRTPoly>& ones,
+                            int32_t rotation, uint32_t batchSize) {
+    BatchResult res;
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(0);
+    try {
+        Plaintext result;
+        for (const auto& ptxt : ptxts) {
+            auto c = cc->Encrypt(keys.publicKey, ptxt);
+            c = cc->Rescale(cc->EvalMult(c, ones));
+            c = cc->EvalRotate(c, rotation);
+            cc->Decrypt(keys.secretKey, c, &result);
+            result->SetLength(batchSize);
+            res.outputs.push_back(result->GetRealPackedValue());
+        }
+    }
+    catch (const std::exception& e) {
+        res.exception = true;
+    }
+    return res;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    std::string keyTarget = config["keyTarget"];
+    uint32_t workloadOps = std::stoul(config["keyWorkload"]);
+    uint32_t wordStep    = std::stoul(config["keyWordStep"]);
+    bool skipSecretKey   = std::stoi(config["secretKeyAttackDisable"]);
+    faultmodel::Model model;
+    int32_t rotation     = 1;
+
+    if (!faultmodel::parse(config["faultModel"], model)) {
+        std::cerr << "[ERROR] faultModel desconocido: " << config["faultModel"] << "\n";
+        return 1;
+    }
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_keys/";
+    std::string endFile = "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    // EvalMult + Rescale necesita al menos un nivel
+    uint32_t multDepth = std::max(RNS_size, 1u);
+    uint32_t batchSize = ringDim >> 1;
+    if(gap>0)
+        batchSize = batchSize >> gap;
+    ScalingTechnique rescaleTech = FIXEDMANUAL;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(rescaleTech);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+    auto keys = cc->KeyGen();
+    cc->EvalMultKeyGen(keys.secretKey);
+    cc->EvalRotateKeyGen(keys.secretKey, {rotation});
+
+    std::vector<Plaintext> ptxts;
+    std::vector<std::vector<double>> inputs;
+    for (uint32_t op = 0; op < workloadOps; ++op) {
+        inputs.push_back(uniform_dist(batchSize, logMin, logMax, seed_input + op, false));
+        ptxts.push_back(cc->MakeCKKSPackedPlaintext(inputs.back()));
+    }
+    auto ones = cc->Encrypt(keys.publicKey, cc->MakeCKKSPackedPlaintext(std::vector<double>(batchSize, 1.0)));
+
+    BatchResult golden = runBatch(cc, keys, ptxts, ones, rotation, batchSize);
+    std::vector<double> expected(batchSize);
+    for (uint32_t i = 0; i < batchSize; ++i)
+        expected[i] = inputs[0][(i + rotation) % batchSize];
+    double golden_norm2 = golden.exception ? INFINITY : norm2(expected, golden.outputs[0], batchSize);
+    if (golden_norm2 >= 0.1) {
+        std::cout << "ERROR!!! Norm2: " << golden_norm2 << std::endl;
+        return 1;
+    }
+
+    std::vector<FaultTarget> targets;
+    for (auto& t : collectKeyTargets(cc, keys, keyTarget)) {
+        if (!(skipSecretKey && t.kind == "secretKey"))
+            targets.push_back(t);
+    }
+    // Copia pristina cacheada: restaurar una palabra es O(1), no se regeneran claves
+    TargetSnapshot snapshot(targets);
+    std::cout << "Targets: " << targets.size() << " limbs de claves, batch de " << workloadOps << " ops" << std::endl;
+
+    // Una linea por fault: modelo,kind,limb,word,bit,norma de cada op separadas por ';'
+    std::string rows;
+    std::string modelName = faultmodel::name(model);
+    std::vector<faultmodel::WordMask> masks;
+    faultmodel::DenseMask dense;
+    for (size_t t = 0; t < targets.size(); ++t) {
+        for (size_t word = 0; word < targets[t].numWords; word += wordStep) {
+            for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+                faultmodel::generate(model, snapshot.pristine(t), targets[t].numWords, word, bit, masks);
+                faultmodel::densify(masks, dense);
+                snapshot.apply(t, dense);
+                BatchResult faulty = runBatch(cc, keys, ptxts, ones, rotation, batchSize);
+                snapshot.restore(t, dense);
+
+                rows.append(modelName + "," + targets[t].kind + "," + std::to_string(targets[t].limb) + "," +
+                            std::to_string(word) + "," + std::to_string(bit) + ",");
+                if (faulty.exception) {
+                    rows.append("EXC\n");
+                    continue;
+                }
+                for (uint32_t op = 0; op < workloadOps; ++op) {
+                    rows.append(std::to_string(norm2(golden.outputs[op], faulty.outputs[op], batchSize)));
+                    rows.append(op + 1 < workloadOps ? ";" : "\n");
+                }
+            }
+        }
+        std::cout << "Target " << targets[t].kind << " limb " << targets[t].limb << " done" << std::endl;
+    }
+
+    if (!snapshot.isClean())
+        std::cerr << "[ERROR] Las claves no quedaron restauradas\n";
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream keysFile(dir_log+"out_keys"+endFile);
+    if (!keysFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero de claves\n";
+        return 1;
+    }
+    keysFile << rows;
+    keysFile.close();
+    std::cout<< "File of keys is save" << std::endl;
+    return 0;
+}
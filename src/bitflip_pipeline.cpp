@@ -0,0 +1,209 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "pipeline.h"
+#include "fault_model.h"
+#include "fault_pruning.h"
+
+namespace fs = std::filesystem;
+
+// Campaña sobre un pipeline homomorfico (config: pipeline=mult,add:2,rot:1,poly).
+// La corrida golden guarda el cifrado a la entrada de cada etapa; un fault en la
+// etapa k se inyecta sobre ese snapshot y solo se recalculan las etapas k..S-1.
+// Etapa S es el cifrado final, justo antes del Decrypt.
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    std::string spec     = config["pipeline"];
+    std::string stageSel = config["pipelineStage"];
+    uint32_t coeffStep   = std::stoul(config["pipelineCoeffStep"]);
+    bool prune           = std::stoi(config["pipelinePrune"]);
+    uint32_t verifyCount = std::stoul(config["pruneVerify"]);
+    faultmodel::Model model;
+
+    std::vector<Stage> stages = parsePipeline(spec);
+
+    if (!faultmodel::parse(config["faultModel"], model)) {
+        std::cerr << "[ERROR] faultModel desconocido: " << config["faultModel"] << "\n";
+        return 1;
+    }
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_pipeline/";
+    std::string endFile = "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    // RNS_limbs fija la profundidad, pero nunca por debajo de lo que pide el pipeline
+    uint32_t multDepth = std::max(RNS_size, Pipeline::depth(stages));
+    uint32_t batchSize = ringDim >> 1;
+    if(gap>0)
+        batchSize = batchSize >> gap;
+    ScalingTechnique rescaleTech = FIXEDMANUAL;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(rescaleTech);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+
+    auto keys = cc->KeyGen();
+    Pipeline pipeline(cc, stages);
+    pipeline.genKeys(keys.secretKey);
+
+    std::vector<double> input = uniform_dist(batchSize, logMin, logMax, seed_input, false);
+    Plaintext ptxt1 = cc->MakeCKKSPackedPlaintext(input);
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+    auto c = cc->Encrypt(keys.publicKey, ptxt1);
+
+    std::vector<Ciphertext<DCRTPoly>> snapshots = pipeline.runGolden(c);
+
+    Plaintext golden_result;
+    cc->Decrypt(keys.secretKey, snapshots.back(), &golden_result);
+    golden_result->SetLength(batchSize);
+    std::vector<double> golden_result_vec = golden_result->GetRealPackedValue();
+    std::vector<double> expected = pipeline.evalPlain(input);
+    double golden_norm2 = norm2(expected, golden_result_vec, batchSize);
+    if (golden_norm2 >= 0.1) {
+        std::cout << "ERROR!!! Norm2: " << golden_norm2 << "  Pipeline: " << spec << std::endl;
+        return 1;
+    }
+
+    size_t firstStage = 0;
+    size_t lastStage  = pipeline.size();
+    if (stageSel != "all") {
+        firstStage = lastStage = std::stoul(stageSel);
+        if (firstStage > pipeline.size()) {
+            std::cerr << "[ERROR] pipelineStage fuera de rango (0.." << pipeline.size() << ")\n";
+            return 1;
+        }
+    }
+
+    // Una linea por fault: modelo,stage,nombre,limb,coeff,bit,norma (EXC si el decode tira)
+    std::string rows;
+    std::string modelName = faultmodel::name(model);
+    std::vector<faultmodel::WordMask> masks;
+    faultmodel::DenseMask dense;
+    Plaintext result_bitFlip;
+
+    // Inyecta en el snapshot de la etapa k, recalcula desde ahi y restaura
+    auto injectAt = [&](size_t k, uint32_t limb, uint32_t coeff, uint32_t bit) {
+        auto& limbs = snapshots[k]->GetElements()[0].GetAllElements();
+        uint64_t* words = reinterpret_cast<uint64_t*>(&limbs[limb][0]);
+        // El snapshot no tiene fault aplicado, sirve de pristino para stuck-at
+        faultmodel::generate(model, words, ringDim, coeff, bit, masks);
+        faultmodel::densify(masks, dense);
+        faultmodel::applyXor(words, dense);
+        std::string norm = "EXC";
+        try {
+            auto out = pipeline.resumeFrom(k, snapshots[k]);
+            cc->Decrypt(keys.secretKey, out, &result_bitFlip);
+            result_bitFlip->SetLength(batchSize);
+            std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+            norm = std::to_string(norm2(golden_result_vec, result_bitFlip_vec, batchSize));
+        }
+        catch (const std::exception& e) {
+            // Decode tira excepcion cuando el error de aproximacion es muy grande
+        }
+        faultmodel::applyXor(words, dense);
+        return norm;
+    };
+    auto appendRow = [&](size_t k, const std::string& name, const FaultSite& site, const std::string& norm) {
+        rows.append(modelName + "," + std::to_string(k) + "," + name + "," + std::to_string(site.limb) + "," +
+                    std::to_string(site.coeff) + "," + std::to_string(site.bit) + "," + norm + "\n");
+    };
+
+    for (size_t k = firstStage; k <= lastStage; ++k) {
+        std::string name = k < pipeline.size() ? stageName(pipeline.stage(k)) : "final";
+        auto& limbs = snapshots[k]->GetElements()[0].GetAllElements();
+        std::cout << "Stage " << k << " (" << name << "): " << limbs.size() << " limbs" << std::endl;
+
+        if (prune && pipeline.linearFrom(k)) {
+            // Un representante por clase, el resto hereda su norma
+            std::vector<FaultClass> classes = pruneFaultSpace({snapshots[k]->GetElements()[0]}, model, gap, coeffStep);
+            std::vector<std::string> classNorm(classes.size());
+            for (size_t c = 0; c < classes.size(); ++c) {
+                const FaultSite& rep = classes[c].members[0];
+                classNorm[c] = classes[c].rule == PruneRule::IDENTITY ? std::to_string(0.0)
+                                                                      : injectAt(k, rep.limb, rep.coeff, rep.bit);
+                for (const auto& site : classes[c].members)
+                    appendRow(k, name, site, classNorm[c]);
+            }
+            std::cout << "  Poda: " << prunedSpaceSize(classes) << " faults, " << pruneInjections(classes)
+                      << " inyecciones" << std::endl;
+
+            // Muestra de faults podados inyectados de verdad; la diferencia relativa
+            // contra el representante mide cuanto se aleja de la prediccion
+            uint32_t mismatches = 0;
+            double worst = 0;
+            auto sample = pruneVerifySample(classes, verifyCount, seed);
+            for (const auto& s : sample) {
+                std::string norm = injectAt(k, s.second.limb, s.second.coeff, s.second.bit);
+                const std::string& expectedNorm = classNorm[s.first];
+                double diff = 0;
+                if (norm == "EXC" || expectedNorm == "EXC")
+                    diff = norm == expectedNorm ? 0 : INFINITY;
+                else {
+                    double a = std::stod(norm), b = std::stod(expectedNorm);
+                    diff = std::fabs(a - b) / std::max(std::fabs(b), 1e-12);
+                }
+                worst = std::max(worst, diff);
+                if (diff > 1e-3) {
+                    ++mismatches;
+                    std::cerr << "[WARN] Poda " << pruneRuleName(classes[s.first].rule) << " limb " << s.second.limb
+                              << " coeff " << s.second.coeff << " bit " << s.second.bit << ": " << norm
+                              << " vs " << expectedNorm << "\n";
+                }
+            }
+            if (!sample.empty())
+                std::cout << "  Verificacion: " << sample.size() << " faults, " << mismatches
+                          << " distintos, max diferencia relativa " << worst << std::endl;
+            continue;
+        }
+        if (prune)
+            std::cerr << "[WARN] Etapa " << k << ": hay etapas no lineales despues, sin poda\n";
+
+        for (uint32_t limb = 0; limb < limbs.size(); ++limb) {
+            for (uint32_t coeff = 0; coeff < ringDim; coeff += coeffStep) {
+                for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model))
+                    appendRow(k, name, {0, limb, coeff, bit}, injectAt(k, limb, coeff, bit));
+            }
+        }
+    }
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream pipelineFile(dir_log+"out_pipeline"+endFile);
+    if (!pipelineFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero del pipeline\n";
+        return 1;
+    }
+    pipelineFile << rows;
+    pipelineFile.close();
+    std::cout<< "File of pipeline is save" << std::endl;
+    return 0;
+}
@@ -1,8 +1,38 @@
 #include "openfhe.h"
 #include "utils.h"
 
+extern "C" void sync_marker();
+asm(
+    ".global sync_marker       \n"
+    ".type   sync_marker, @function \n"
+    "sync_marker:              \n"
+    "    nop                   \n"
+    "    ret                   \n"
+);
+
+extern "C" void addr_label();
+asm(
+    ".global addr_label       \n"
+    ".type   addr_label, @function \n"
+    "addr_label:              \n"
+    "    nop                 \n"
+    "    ret                 \n"
+);
+
+// PIN lee la norma de la iteracion por el puntero (vulnerabilidad por sitio)
+extern "C" void report_norm(const double* norm);
+asm(
+    ".global report_norm       \n"
+    ".type   report_norm, @function \n"
+    "report_norm:              \n"
+    "    nop                   \n"
+    "    ret                   \n"
+);
+
 int main(int argc, char* argv[]) {
     const char* home = getenv("HOME");
+    // Iteraciones del sweep de pintool_BitFlip_registers, un fault por iteracion
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 1;
     uint32_t firstMod    = 60;
     uint32_t scaleMod    = 50;
     uint32_t logN = 3;
@@ -43,11 +73,23 @@ int main(int argc, char* argv[]) {
         Plaintext result_bitFlip;
         double norm2_abs = 0;
         std::string norms2;
-        cc->Decrypt(keys.secretKey, c, &result_bitFlip);
-        result_bitFlip->SetLength(batchSize);
-        std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
-        norm2_abs = norm2(golden_result_vec, result_bitFlip_vec,batchSize);
-        std::cout << "Norm2: " << norm2_abs << std::endl;
+        addr_label();
+        for (int it = 0; it < iterations; ++it) {
+            lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(0);
+            c = cc->Encrypt(keys.publicKey, ptxt1);
+            try {
+                cc->Decrypt(keys.secretKey, c, &result_bitFlip);
+                result_bitFlip->SetLength(batchSize);
+                std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                norm2_abs = norm2(golden_result_vec, result_bitFlip_vec,batchSize);
+            }
+            catch (const std::exception& e) {
+                norm2_abs = INFINITY;
+            }
+            report_norm(&norm2_abs);
+            std::cout << "Norm2: " << norm2_abs << std::endl;
+            sync_marker();
+        }
 
     }
     else
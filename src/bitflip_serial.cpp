@@ -0,0 +1,273 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "fault_model.h"
+#include "cryptocontext-ser.h"
+#include "key/key-ser.h"
+#include "scheme/ckksrns/ckksrns-ser.h"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+// Campaña sobre el cifrado serializado (SerType::BINARY), como si el fault
+// ocurriera en disco o en la red. Se serializa una sola vez a memoria; cada
+// fault hace XOR sobre el buffer, deserializa desde un istream sobre ese
+// mismo buffer (sin copias ni filesystem), desencripta y vuelve a hacer XOR.
+//
+// Cada intento corre en un hijo (fork): un puntero corrupto dentro de
+// cereal/OpenFHE puede crashear en malloc/free con el heap roto o con locks
+// del allocator tomados, y el contexto que registra Deserialize cuando el
+// fault cae en los bytes del CryptoContext se queda en la factory. En el hijo
+// todo eso muere con el proceso; el padre solo ve el resultado.
+
+// streambuf de solo lectura sobre un buffer existente
+struct MemBuf : std::streambuf {
+    MemBuf(char* data, size_t size) { setg(data, data, data + size); }
+};
+
+// Resultado que el hijo deja en memoria compartida antes de salir
+struct TrialResult {
+    Outcome outcome;
+    ErrorMetrics metrics;
+};
+
+// Un largo corrupto puede dejar al parser en un loop; pasado esto es crash
+static const unsigned kTrialTimeoutSec = 30;
+
+// XOR de burst bits consecutivos a partir de (offset, bit). Aplicarlo dos veces restaura.
+static void flipBurst(std::string& buf, size_t offset, uint32_t bit, uint32_t burst) {
+    size_t pos = offset * 8 + bit;
+    size_t end = std::min(pos + burst, buf.size() * 8);
+    for (; pos < end; ++pos)
+        buf[pos / 8] ^= static_cast<char>(1u << (pos % 8));
+}
+
+// Rangos [inicio, fin) del buffer con los coeficientes de cada limb. cereal
+// escribe los NativeVector como palabras crudas, se buscan los dos primeros
+// coeficientes de cada limb para ubicarlos.
+static std::vector<std::pair<size_t, size_t>> payloadRanges(const std::string& buf, const Ciphertext<DCRTPoly>& c) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t from = 0;
+    for (const auto& elem : c->GetElements()) {
+        for (const auto& limb : elem.GetAllElements()) {
+            const auto& values = limb.GetValues();
+            size_t bytes = values.GetLength() * sizeof(uint64_t);
+            uint64_t head[2] = {values[0].ConvertToInt(), values[values.GetLength() > 1 ? 1 : 0].ConvertToInt()};
+            size_t pos = buf.find(std::string(reinterpret_cast<const char*>(head), sizeof(head)), from);
+            if (pos == std::string::npos) {
+                std::cerr << "[WARN] No encontre un limb en el buffer serializado\n";
+                continue;
+            }
+            ranges.emplace_back(pos, std::min(pos + bytes, buf.size()));
+            from = pos + bytes;
+        }
+    }
+    return ranges;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    uint32_t burst       = std::stoul(config["serialBurst"]);
+    uint32_t offsetStep  = std::stoul(config["serialOffsetStep"]);
+    bool payloadOnly     = std::stoi(config["serialPayloadOnly"]);
+    double sdcBits       = std::stod(config["sdcThresholdBits"]);
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_serial/";
+    std::string endFile = "_" + std::to_string(burst) + "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    uint32_t multDepth = RNS_size;
+    uint32_t batchSize = ringDim >> 1;
+    if(gap>0)
+        batchSize = batchSize >> gap;
+    ScalingTechnique rescaleTech = FIXEDMANUAL;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(rescaleTech);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+
+    auto keys = cc->KeyGen();
+
+    std::vector<double> input = uniform_dist(batchSize, logMin, logMax, seed_input, false);
+    Plaintext ptxt1 = cc->MakeCKKSPackedPlaintext(input);
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(seed);
+    auto c = cc->Encrypt(keys.publicKey, ptxt1);
+
+    Plaintext golden_result;
+    cc->Decrypt(keys.secretKey, c, &golden_result);
+    golden_result->SetLength(batchSize);
+    std::vector<double> golden_result_vec = golden_result->GetRealPackedValue();
+    double golden_norm2 = norm2(input, golden_result_vec, batchSize);
+    // Error propio de CKKS: los bits perdidos de un fault se miden contra este piso
+    double noiseFloor = errorMetrics<METRIC_LINF>(input.data(), golden_result_vec.data(), batchSize).linf;
+    if (golden_norm2 >= 0.1) {
+        std::cout << "ERROR!!! Norm2: " << golden_norm2 << "  Input/output: " << input << " " << golden_result  << std::endl;
+        return 1;
+    }
+
+    std::ostringstream oss;
+    Serial::Serialize(c, oss, SerType::BINARY);
+    std::string buf = oss.str();
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (payloadOnly)
+        ranges = payloadRanges(buf, c);
+    else
+        ranges.emplace_back(0, buf.size());
+    size_t totalBytes = 0;
+    for (const auto& r : ranges)
+        totalBytes += r.second - r.first;
+    std::cout << "Serializado: " << buf.size() << " bytes, " << totalBytes << " bytes atacados en "
+              << ranges.size() << " rangos" << std::endl;
+
+    auto* shared = static_cast<TrialResult*>(
+        mmap(nullptr, sizeof(TrialResult), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (shared == MAP_FAILED) {
+        std::cerr << "[ERROR] No pude mapear la memoria compartida\n";
+        return 1;
+    }
+    std::cout.flush();
+
+    // Una linea por fault: modelo,offset,bit,outcome,rms,linf,bits perdidos. El buffer es de bytes,
+    // el modelo es siempre una rafaga de serialBurst bits.
+    std::string rows;
+    std::string modelName = faultmodel::name(burst > 1 ? faultmodel::Model{faultmodel::Kind::BURST, burst}
+                                                       : faultmodel::Model{faultmodel::Kind::BIT, 1});
+    rows.reserve(totalBytes / offsetStep * 8 * 32);
+    uint64_t counts[5] = {0, 0, 0, 0, 0};
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (const auto& r : ranges) {
+        for (size_t offset = r.first; offset < r.second; offset += offsetStep) {
+            for (uint32_t bit = 0; bit < 8; ++bit) {
+                flipBurst(buf, offset, bit, burst);
+                Outcome outcome = Outcome::CRASH;
+                ErrorMetrics metrics;
+
+                pid_t pid = fork();
+                if (pid < 0) {
+                    std::cerr << "[ERROR] fork fallo en offset " << offset << "\n";
+                    return 1;
+                }
+                if (pid == 0) {
+                    // Hijo: sin core dumps por cada crash y sin el pool de
+                    // OpenMP del padre (sus hilos no existen despues del fork)
+                    struct rlimit noCore{0, 0};
+                    setrlimit(RLIMIT_CORE, &noCore);
+                    alarm(kTrialTimeoutSec);
+#ifdef _OPENMP
+                    omp_set_num_threads(1);
+#endif
+                    TrialResult result{Outcome::MASKED, ErrorMetrics()};
+                    Ciphertext<DCRTPoly> faulty;
+                    MemBuf mb(&buf[0], buf.size());
+                    std::istream is(&mb);
+                    bool parsed = false;
+                    try {
+                        Serial::Deserialize(faulty, is, SerType::BINARY);
+                        parsed = faulty != nullptr;
+                    }
+                    catch (const std::exception& e) {
+                        parsed = false;
+                    }
+                    if (!parsed) {
+                        result.outcome = Outcome::PARSE_FAIL;
+                    }
+                    else {
+                        try {
+                            Plaintext result_bitFlip;
+                            cc->Decrypt(keys.secretKey, faulty, &result_bitFlip);
+                            result_bitFlip->SetLength(batchSize);
+                            std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                            result.metrics = errorMetrics<METRIC_RMS | METRIC_LINF | METRIC_BITS>(
+                                golden_result_vec.data(), result_bitFlip_vec.data(), batchSize, noiseFloor);
+                            result.outcome = classifyOutcome(result.metrics, sdcBits);
+                        }
+                        catch (const std::exception& e) {
+                            // Contexto distinto, limbs de menos o decode con error enorme
+                            result.outcome = Outcome::DECRYPT_FAIL;
+                        }
+                    }
+                    *shared = result;
+                    _exit(0);
+                }
+
+                // Padre: muerto por señal (SIGSEGV, SIGABRT, timeout) o salida
+                // distinta de 0 es crash
+                int status = 0;
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                    outcome = shared->outcome;
+                    metrics = shared->metrics;
+                }
+
+                flipBurst(buf, offset, bit, burst);
+                ++counts[static_cast<int>(outcome)];
+                rows.append(modelName + "," + std::to_string(offset) + "," + std::to_string(bit) + "," + outcomeName(outcome) + ",");
+                if (outcome == Outcome::SDC || outcome == Outcome::MASKED)
+                    rows.append(std::to_string(metrics.rms) + "," + std::to_string(metrics.linf) + "," +
+                                std::to_string(metrics.bitsLost));
+                rows.append("\n");
+            }
+        }
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t trials = counts[0] + counts[1] + counts[2] + counts[3] + counts[4];
+    std::cout << trials << " faults en " << secs << " s (" << trials / secs << " faults/s)" << std::endl;
+    for (Outcome o : {Outcome::MASKED, Outcome::SDC, Outcome::PARSE_FAIL, Outcome::DECRYPT_FAIL, Outcome::CRASH})
+        std::cout << "  " << outcomeName(o) << ": " << counts[static_cast<int>(o)] << std::endl;
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream serialFile(dir_log+"out_serial"+endFile);
+    if (!serialFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero de serializacion\n";
+        return 1;
+    }
+    serialFile << rows;
+    serialFile.close();
+    munmap(shared, sizeof(TrialResult));
+    std::cout<< "File of serial is save" << std::endl;
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "fault_targets.h"
+
+namespace fs = std::filesystem;
+
+// Resultado de correr el workload con (o sin) un fault persistente activo.
+struct WorkloadResult {
+    std::vector<std::vector<double>> outputs;  // salida decodificada de cada operacion
+    std::vector<double> accOutput;             // salida de la suma acumulada
+    bool exception = false;
+};
+
+// Workload: W cifrados/descifrados y una suma acumulada con EvalAdd, asi se ve
+// como el error de una tabla corrupta se acumula entre operaciones.
+static WorkloadResult runWorkload(CryptoContext<DCRTPoly>& cc, const KeyPair<DCRTPoly>& keys,
+                                  const std::vector<Plaintext>& ptxts, uint32_t batchSize) {
+    WorkloadResult res;
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(0);
+    try {
+        Ciphertext<DCRTPoly> acc;
+        Plaintext result;
+        for (const auto& ptxt : ptxts) {
+            auto c = cc->Encrypt(keys.publicKey, ptxt);
+            acc = acc ? cc->EvalAdd(acc, c) : c;
+            cc->Decrypt(keys.secretKey, c, &result);
+            result->SetLength(batchSize);
+            res.outputs.push_back(result->GetRealPackedValue());
+        }
+        cc->Decrypt(keys.secretKey, acc, &result);
+        result->SetLength(batchSize);
+        res.accOutput = result->GetRealPackedValue();
+    }
+    catch (const std::exception& e) {
+        res.exception = true;
+    }
+    return res;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Need number of seeds and number seeds input \n";
+        return 1;
+    }
+    int seed = std::stoi(argv[1]);
+    int seed_input = std::stoi(argv[2]);
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    uint32_t RNS_size    = std::stoul(config["RNS_limbs"]);
+    uint32_t firstMod    = std::stoul(config["firstMod"]);
+    uint32_t scaleMod    = std::stoul(config["scaleMod"]);
+    uint32_t logN        = std::stoul(config["logN"]);
+    uint32_t ringDim     = 1 << logN;
+    uint32_t gap         = std::stoul(config["gap"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+    std::string tableTarget = config["tableTarget"];
+    uint32_t workloadOps = std::stoul(config["tableWorkload"]);
+    uint32_t wordStep    = std::stoul(config["tableWordStep"]);
+    faultmodel::Model model;
+
+    if (!faultmodel::parse(config["faultModel"], model)) {
+        std::cerr << "[ERROR] faultModel desconocido: " << config["faultModel"] << "\n";
+        return 1;
+    }
+
+    std::string prelog = path + "/logs/";
+    std::string info = "log_"+std::to_string(RNS_size) + "_" + std::to_string(logN) + "_" + std::to_string(firstMod) + "_" +
+                                        std::to_string(scaleMod) + "_" + std::to_string(gap) +"_" + std::to_string(logMin) + "_" + std::to_string(logMax) +"/";
+    std::string dir_log = prelog + info + "log_tables/";
+    std::string endFile = "_" + std::to_string(seed) + "_" + std::to_string(seed_input) + ".txt";
+
+    uint32_t multDepth = RNS_size;
+    uint32_t batchSize = ringDim >> 1;
+    if(gap>0)
+        batchSize = batchSize >> gap;
+    ScalingTechnique rescaleTech = FIXEDMANUAL;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(multDepth);
+    parameters.SetScalingModSize(scaleMod);
+    parameters.SetFirstModSize(firstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(rescaleTech);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+
+    auto keys = cc->KeyGen();
+
+    std::vector<Plaintext> ptxts;
+    std::vector<std::vector<double>> inputs;
+    for (uint32_t op = 0; op < workloadOps; ++op) {
+        inputs.push_back(uniform_dist(batchSize, logMin, logMax, seed_input + op, false));
+        ptxts.push_back(cc->MakeCKKSPackedPlaintext(inputs.back()));
+    }
+
+    WorkloadResult golden = runWorkload(cc, keys, ptxts, batchSize);
+    double golden_norm2 = golden.exception ? INFINITY : norm2(inputs[0], golden.outputs[0], batchSize);
+    if (golden_norm2 >= 0.1) {
+        std::cout << "ERROR!!! Norm2: " << golden_norm2 << std::endl;
+        return 1;
+    }
+
+    // Las tablas ya estan precomputadas (KeyGen y Encrypt pasan por la NTT)
+    TargetSnapshot snapshot(collectNTTTables(cc, tableTarget));
+    const auto& targets = snapshot.targets();
+    std::cout << "Targets: " << targets.size() << " tablas, workload de " << workloadOps << " ops" << std::endl;
+
+    // Una linea por fault: modelo,kind,limb,word,bit,norma de cada op separadas por ';',norma de la suma
+    std::string rows;
+    std::string modelName = faultmodel::name(model);
+    std::vector<faultmodel::WordMask> masks;
+    faultmodel::DenseMask dense;
+    for (size_t t = 0; t < targets.size(); ++t) {
+        for (size_t word = 0; word < targets[t].numWords; word += wordStep) {
+            for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+                faultmodel::generate(model, snapshot.pristine(t), targets[t].numWords, word, bit, masks);
+                faultmodel::densify(masks, dense);
+                snapshot.apply(t, dense);
+                WorkloadResult faulty = runWorkload(cc, keys, ptxts, batchSize);
+                snapshot.restore(t, dense);
+                if (targets[t].kind == "modulus")
+                    pruneForeignNTTTables(cc);
+
+                rows.append(modelName + "," + targets[t].kind + "," + std::to_string(targets[t].limb) + "," +
+                            std::to_string(word) + "," + std::to_string(bit) + ",");
+                if (faulty.exception) {
+                    rows.append("EXC,EXC\n");
+                    continue;
+                }
+                for (uint32_t op = 0; op < workloadOps; ++op) {
+                    rows.append(std::to_string(norm2(golden.outputs[op], faulty.outputs[op], batchSize)));
+                    rows.append(op + 1 < workloadOps ? ";" : ",");
+                }
+                rows.append(std::to_string(norm2(golden.accOutput, faulty.accOutput, batchSize)) + "\n");
+            }
+        }
+        std::cout << "Target " << targets[t].kind << " limb " << targets[t].limb << " done" << std::endl;
+    }
+
+    if (!snapshot.isClean())
+        std::cerr << "[ERROR] Las tablas no quedaron restauradas\n";
+
+    if (!fs::exists(dir_log)) {
+        if (!fs::create_directories(dir_log)) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream tablesFile(dir_log+"out_tables"+endFile);
+    if (!tablesFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero de tablas\n";
+        return 1;
+    }
+    tablesFile << rows;
+    tablesFile.close();
+    std::cout<< "File of tables is save" << std::endl;
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "openfhe.h"
+#include "utils.h"
+#include "bench.h"
+
+namespace fs = std::filesystem;
+
+// Benchmarks de los kernels que usan las campañas y del loop por flip, barriendo
+// logN, limbs, firstMod, scaleMod y gap (listas separadas por comas en config.txt).
+// Uso: ckks_bench [salida.json]; por defecto logs/bench/ckks_bench.json
+int main(int argc, char* argv[]) {
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    auto config = loadConfig(path + "config.txt");
+
+    std::vector<uint32_t> logNs     = parseList(config["benchLogN"]);
+    std::vector<uint32_t> limbList  = parseList(config["benchLimbs"]);
+    std::vector<uint32_t> firstMods = parseList(config["benchFirstMod"]);
+    std::vector<uint32_t> scaleMods = parseList(config["benchScaleMod"]);
+    std::vector<uint32_t> gaps      = parseList(config["benchGap"]);
+    uint32_t warmup      = std::stoul(config["benchWarmup"]);
+    uint32_t reps        = std::stoul(config["benchReps"]);
+    uint32_t flips       = std::stoul(config["benchFlips"]);
+    int logMin           = std::stoi(config["logMin"]);
+    int logMax           = std::stoi(config["logMax"]);
+
+    std::string outFile = argc > 1 ? argv[1] : path + "/logs/bench/ckks_bench.json";
+    BenchRunner runner(warmup, reps);
+
+    for (uint32_t logN : logNs) {
+    for (uint32_t limbs : limbList) {
+    for (uint32_t firstMod : firstMods) {
+    for (uint32_t scaleMod : scaleMods) {
+    for (uint32_t gap : gaps) {
+        if (scaleMod >= firstMod || gap + 1 >= logN) {
+            std::cerr << "[WARN] Salteo logN=" << logN << " firstMod=" << firstMod << " scaleMod=" << scaleMod
+                      << " gap=" << gap << "\n";
+            continue;
+        }
+        uint32_t ringDim = 1 << logN;
+        uint32_t batchSize = ringDim >> 1;
+        if(gap>0)
+            batchSize = batchSize >> gap;
+        CCParams<CryptoContextCKKSRNS> parameters;
+        parameters.SetMultiplicativeDepth(limbs - 1);
+        parameters.SetScalingModSize(scaleMod);
+        parameters.SetFirstModSize(firstMod);
+        parameters.SetBatchSize(batchSize);
+        parameters.SetRingDim(ringDim);
+        parameters.SetScalingTechnique(FIXEDMANUAL);
+        parameters.SetSecurityLevel(HEStd_NotSet);
+        CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+        cc->Enable(PKE);
+        cc->Enable(LEVELEDSHE);
+        auto keys = cc->KeyGen();
+
+        BenchParams params = {{"logN", std::to_string(logN)}, {"limbs", std::to_string(limbs)},
+                              {"firstMod", std::to_string(firstMod)}, {"scaleMod", std::to_string(scaleMod)},
+                              {"gap", std::to_string(gap)}};
+        std::cout << "logN " << logN << " limbs " << limbs << " firstMod " << firstMod << " scaleMod "
+                  << scaleMod << " gap " << gap << std::endl;
+
+        std::vector<double> input = uniform_dist(batchSize, logMin, logMax, 1, false);
+        Plaintext ptxt = cc->MakeCKKSPackedPlaintext(input);
+        auto c = cc->Encrypt(keys.publicKey, ptxt);
+        Plaintext result;
+        cc->Decrypt(keys.secretKey, c, &result);
+        result->SetLength(batchSize);
+        std::vector<double> golden = result->GetRealPackedValue();
+        DCRTPoly poly = c->GetElements()[0];
+        auto decoded = std::dynamic_pointer_cast<CKKSPackedEncoding>(result);
+
+        runner.run("Encode", params, [&] { cc->MakeCKKSPackedPlaintext(input); });
+        runner.run("Encrypt", params, [&] { cc->Encrypt(keys.publicKey, ptxt); });
+        runner.run("SwitchFormat", params, [&] { poly.SwitchFormat(); });
+        runner.run("Decrypt", params, [&] { cc->Decrypt(keys.secretKey, c, &result); });
+        runner.run("Decode", params, [&] {
+            decoded->Decode(c->GetNoiseScaleDeg(), c->GetScalingFactor(), FIXEDMANUAL, EXEC_EVALUATION);
+        });
+
+        // Loop de una campaña: restore, flip, decrypt, metrica y registro. Cada muestra
+        // son `flips` faults sobre c0 limb 0; flips/s = flips * 1e6 / mediana
+        auto& limb = c->GetElements()[0].GetAllElements()[0];
+        uint64_t* words = reinterpret_cast<uint64_t*>(&limb[0]);
+        std::vector<uint64_t> pristine(words, words + ringDim);
+        std::string rows;
+        uint64_t site = 0;
+        Plaintext result_bitFlip;
+        BenchParams loopParams = params;
+        loopParams.emplace_back("flips", std::to_string(flips));
+        const BenchStats& loop = runner.run("FlipLoop", loopParams, [&] {
+            rows.clear();
+            for (uint32_t f = 0; f < flips; ++f, ++site) {
+                uint32_t coeff = (site / 64) % ringDim;
+                uint32_t bit = site % 64;
+                words[coeff] = pristine[coeff];
+                words[coeff] ^= 1ULL << bit;
+                double norm = INFINITY;
+                try {
+                    cc->Decrypt(keys.secretKey, c, &result_bitFlip);
+                    result_bitFlip->SetLength(batchSize);
+                    std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                    norm = norm2(golden, result_bitFlip_vec, batchSize);
+                }
+                catch (const std::exception& e) {
+                    // Decode tira excepcion cuando el error de aproximacion es muy grande
+                }
+                rows.append(std::to_string(coeff) + "," + std::to_string(bit) + "," + std::to_string(norm) + "\n");
+                words[coeff] = pristine[coeff];
+            }
+        });
+        std::cout << "  FlipLoop: " << flips * 1e6 / loop.median << " flips/s" << std::endl;
+    }}}}}
+
+    fs::path outPath(outFile);
+    if (outPath.has_parent_path() && !fs::exists(outPath.parent_path())) {
+        if (!fs::create_directories(outPath.parent_path())) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+    std::ofstream benchFile(outFile);
+    if (!benchFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero del benchmark\n";
+        return 1;
+    }
+    benchFile << runner.json();
+    benchFile.close();
+    std::cout<< "File of bench is save" << std::endl;
+    return 0;
+}
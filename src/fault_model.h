@@ -0,0 +1,222 @@
+#ifndef FAULT_MODEL_MATI_H
+#define FAULT_MODEL_MATI_H
+
+// Modelo de fault compartido entre los drivers (in-process) y los pintools,
+// por eso es header-only y no depende de OpenFHE.
+//
+//   bit          1 bit
+//   burst:w      w bits adyacentes, puede cruzar a la palabra siguiente
+//   multi:w      el mismo bit en w palabras consecutivas
+//   stuck0       el bit queda en 0
+//   stuck1       el bit queda en 1
+//   byte         se invierten los 8 bits del byte que contiene al bit
+//   word         se invierte la palabra entera
+//
+// Todo modelo se reduce a pares (palabra, mascara XOR). Stuck-at depende del
+// valor que el fault pisa: la mascara se calcula contra las palabras tal como
+// estan justo antes de aplicarlo (despues de cualquier cambio de formato), asi
+// aplicar y revertir son el mismo XOR.
+//
+// generateBatch arma las mascaras de muchos sitios de una vez (campañas en
+// batch); applyXor sobre mascaras densas va de a dos palabras con SSE2. Los
+// pintools que atacan un valor suelto (registro, lane, acceso a memoria) usan
+// xorValue: multi:w no tiene palabras vecinas ahi y queda en un bit.
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace faultmodel {
+
+enum class Kind { BIT, BURST, MULTI_WORD, STUCK_0, STUCK_1, BYTE, WORD };
+
+struct Model {
+    Kind kind = Kind::BIT;
+    uint32_t width = 1;     // bits de la rafaga (burst) o palabras (multi)
+};
+
+struct WordMask {
+    size_t word;
+    uint64_t mask;
+};
+
+// Sin excepciones: los pintools se compilan con -fno-exceptions
+inline bool parse(const std::string& spec, Model& out) {
+    std::string name = spec.substr(0, spec.find(':'));
+    uint32_t width = 1;
+    if (spec.find(':') != std::string::npos)
+        width = static_cast<uint32_t>(std::strtoul(spec.c_str() + spec.find(':') + 1, nullptr, 10));
+    if (width == 0)
+        width = 1;
+
+    if (name == "bit" || name.empty()) out = {Kind::BIT, 1};
+    else if (name == "burst")          out = {Kind::BURST, std::min(width, 64u)};
+    else if (name == "multi")          out = {Kind::MULTI_WORD, width};
+    else if (name == "stuck0")         out = {Kind::STUCK_0, 1};
+    else if (name == "stuck1")         out = {Kind::STUCK_1, 1};
+    else if (name == "byte")           out = {Kind::BYTE, 8};
+    else if (name == "word")           out = {Kind::WORD, 64};
+    else return false;
+    return true;
+}
+
+inline std::string name(const Model& m) {
+    switch (m.kind) {
+        case Kind::BIT:        return "bit";
+        case Kind::BURST:      return "burst:" + std::to_string(m.width);
+        case Kind::MULTI_WORD: return "multi:" + std::to_string(m.width);
+        case Kind::STUCK_0:    return "stuck0";
+        case Kind::STUCK_1:    return "stuck1";
+        case Kind::BYTE:       return "byte";
+        case Kind::WORD:       return "word";
+    }
+    return "unknown";
+}
+
+// Bits de inicio que tiene sentido barrer por palabra (byte y word no dependen del bit exacto)
+inline uint32_t bitStride(const Model& m) {
+    if (m.kind == Kind::BYTE) return 8;
+    if (m.kind == Kind::WORD) return 64;
+    return 1;
+}
+
+// Mascara del fault sobre la palabra donde arranca (la unica salvo burst que
+// cruza y multi:w). current es el valor de esa palabra, solo para stuck-at.
+inline uint64_t firstWordMask(const Model& m, uint64_t current, uint32_t bit) {
+    bit &= 63;
+    const uint64_t b = 1ULL << bit;
+    switch (m.kind) {
+        case Kind::BIT:
+        case Kind::MULTI_WORD: return b;
+        case Kind::BURST:      return (m.width >= 64 ? ~0ULL : ((1ULL << m.width) - 1)) << bit;
+        case Kind::STUCK_0:    return current & b;
+        case Kind::STUCK_1:    return ~current & b;
+        case Kind::BYTE:       return 0xFFULL << (bit & ~7u);
+        case Kind::WORD:       return ~0ULL;
+    }
+    return b;
+}
+
+// Pares de un fault sin limpiar out (generate y generateBatch)
+inline void appendMasks(const Model& m, const uint64_t* current, size_t numWords,
+                        size_t word, uint32_t bit, std::vector<WordMask>& out) {
+    if (word >= numWords)
+        return;
+    bit &= 63;
+    uint64_t first = firstWordMask(m, current[word], bit);
+    if (first)
+        out.push_back({word, first});
+    if (m.kind == Kind::BURST && bit + m.width > 64 && word + 1 < numWords) {
+        uint64_t run = m.width >= 64 ? ~0ULL : ((1ULL << m.width) - 1);
+        out.push_back({word + 1, run >> (64 - bit)});
+    }
+    if (m.kind == Kind::MULTI_WORD) {
+        for (size_t w = word + 1; w < numWords && w < word + m.width; ++w)
+            out.push_back({w, first});
+    }
+}
+
+// Mascaras del fault que arranca en (word, bit). current son los valores que
+// el fault va a pisar, solo se leen para stuck-at. Pares con mascara 0 no se
+// emiten.
+inline void generate(const Model& m, const uint64_t* current, size_t numWords,
+                     size_t word, uint32_t bit, std::vector<WordMask>& out) {
+    out.clear();
+    appendMasks(m, current, numWords, word, bit, out);
+}
+
+struct Site {
+    size_t word;
+    uint32_t bit;
+};
+
+// Mascaras de count sitios en un solo buffer: las del sitio k son
+// masks[offsets[k] .. offsets[k + 1]). Todas contra el mismo current.
+inline void generateBatch(const Model& m, const uint64_t* current, size_t numWords, const Site* sites,
+                          size_t count, std::vector<WordMask>& masks, std::vector<uint32_t>& offsets) {
+    masks.clear();
+    offsets.resize(count + 1);
+    offsets[0] = 0;
+    for (size_t k = 0; k < count; ++k) {
+        appendMasks(m, current, numWords, sites[k].word, sites[k].bit, masks);
+        offsets[k + 1] = static_cast<uint32_t>(masks.size());
+    }
+}
+
+// Mascaras densas sobre [first, first + masks.size()), un XOR por palabra del rango
+struct DenseMask {
+    size_t first = 0;
+    std::vector<uint64_t> masks;
+
+    bool empty() const { return masks.empty(); }
+};
+
+inline void densify(const std::vector<WordMask>& pairs, DenseMask& dense) {
+    dense.masks.clear();
+    if (pairs.empty())
+        return;
+    size_t lo = pairs[0].word, hi = pairs[0].word;
+    for (const auto& p : pairs) {
+        lo = std::min(lo, p.word);
+        hi = std::max(hi, p.word);
+    }
+    dense.first = lo;
+    dense.masks.assign(hi - lo + 1, 0);
+    for (const auto& p : pairs)
+        dense.masks[p.word - lo] ^= p.mask;
+}
+
+// XOR in place; aplicar dos veces restaura
+inline void applyXor(uint64_t* words, const DenseMask& dense) {
+    uint64_t* dst = words + dense.first;
+    const uint64_t* src = dense.masks.data();
+    size_t n = dense.masks.size();
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(v, x));
+    }
+#endif
+    for (; i < n; ++i)
+        dst[i] ^= src[i];
+}
+
+// Pares dispersos: cada uno es independiente, se aplican de a uno
+inline void applyXor(uint64_t* words, const std::vector<WordMask>& pairs) {
+    for (const auto& p : pairs)
+        words[p.word] ^= p.mask;
+}
+
+// Fault sobre un valor suelto de bytes bytes (registro, lane, acceso a
+// memoria): bit da la vuelta sobre el tamaño y la mascara se recorta a la
+// palabra de 64 bits que lo contiene. Devuelve la mascara aplicada a esa
+// palabra (0 si stuck-at no cambia nada); word queda con su offset en bytes.
+inline uint64_t xorValue(const Model& m, uint8_t* value, uint32_t bytes, uint32_t bit, uint32_t* word = nullptr) {
+    if (bytes == 0)
+        return 0;
+    bit %= bytes * 8;
+    uint32_t offset = (bit / 64) * 8;
+    uint32_t len = std::min<uint32_t>(8, bytes - offset);
+    uint64_t current = 0;
+    std::memcpy(&current, value + offset, len);
+    uint64_t mask = firstWordMask(m, current, bit);
+    if (len < 8)
+        mask &= (1ULL << (len * 8)) - 1;
+    current ^= mask;
+    std::memcpy(value + offset, &current, len);
+    if (word)
+        *word = offset;
+    return mask;
+}
+
+} // namespace faultmodel
+#endif
@@ -0,0 +1,113 @@
+#include "fault_pruning.h"
+
+#include <unordered_map>
+#include <random>
+
+const char* pruneRuleName(PruneRule rule) {
+    switch (rule) {
+        case PruneRule::NONE:      return "none";
+        case PruneRule::IDENTITY:  return "identity";
+        case PruneRule::MONOMIAL:  return "monomial";
+        case PruneRule::NTT_ORBIT: return "ntt_orbit";
+    }
+    return "unknown";
+}
+
+// Modelos cuyo fault es un unico +-2^b en una palabra
+static bool singleBit(const faultmodel::Model& model) {
+    return model.kind == faultmodel::Kind::BIT || model.kind == faultmodel::Kind::STUCK_0 ||
+           model.kind == faultmodel::Kind::STUCK_1;
+}
+
+// Posicion del monomio X^i: 0 y N/2 tienen norma distinta al resto
+static uint32_t monomialClass(uint32_t coeff, uint32_t ringDim) {
+    if (coeff == 0) return 0;
+    if (coeff == ringDim / 2) return 1;
+    return 2;
+}
+
+std::vector<FaultClass> pruneFaultSpace(const std::vector<DCRTPoly>& elements, const faultmodel::Model& model,
+                                        uint32_t gap, uint32_t coeffStep) {
+    std::vector<FaultClass> classes;
+    std::unordered_map<uint64_t, size_t> byKey;
+    std::vector<faultmodel::WordMask> masks;
+    bool prunable = singleBit(model) && gap == 0;
+
+    // Clave: regla | elemento | limb | bit | posicion. Solo entran flips canonicos
+    auto addToClass = [&](PruneRule rule, const FaultSite& site, uint32_t bit, uint32_t position) {
+        uint64_t key = (uint64_t(rule) << 56) | (uint64_t(site.element) << 48) | (uint64_t(site.limb) << 24) |
+                       (uint64_t(bit) << 8) | position;
+        auto it = byKey.find(key);
+        if (it == byKey.end()) {
+            byKey.emplace(key, classes.size());
+            classes.push_back({rule, true, {site}});
+        }
+        else
+            classes[it->second].members.push_back(site);
+    };
+
+    for (uint32_t e = 0; e < elements.size(); ++e) {
+        const auto& limbs = elements[e].GetAllElements();
+        bool evalFormat = elements[e].GetFormat() == Format::EVALUATION;
+        for (uint32_t limb = 0; limb < limbs.size(); ++limb) {
+            uint64_t q = limbs[limb].GetModulus().ConvertToInt();
+            uint32_t ringDim = limbs[limb].GetLength();
+            const uint64_t* words = reinterpret_cast<const uint64_t*>(&limbs[limb][0]);
+            for (uint32_t coeff = 0; coeff < ringDim; coeff += coeffStep) {
+                for (uint32_t bit = 0; bit < 64; bit += faultmodel::bitStride(model)) {
+                    FaultSite site{e, limb, coeff, bit};
+                    faultmodel::generate(model, words, ringDim, coeff, bit, masks);
+                    if (masks.empty()) {
+                        // Una sola clase por limb, ninguna inyeccion
+                        addToClass(PruneRule::IDENTITY, site, 0, 0);
+                        continue;
+                    }
+                    // Un residuo >= q_l depende de como se reduce en cada coeficiente: no se poda
+                    bool canonical = (words[coeff] ^ masks[0].mask) < q;
+                    if (!prunable || e != 0 || !canonical)
+                        classes.push_back({PruneRule::NONE, canonical, {site}});
+                    else if (evalFormat)
+                        addToClass(PruneRule::NTT_ORBIT, site, bit, 0);
+                    else
+                        addToClass(PruneRule::MONOMIAL, site, bit, monomialClass(coeff, ringDim));
+                }
+            }
+        }
+    }
+    return classes;
+}
+
+std::vector<std::pair<size_t, FaultSite>> pruneVerifySample(const std::vector<FaultClass>& classes,
+                                                            size_t count, uint32_t seed) {
+    // Reservoir sampling sobre los miembros no representantes
+    std::vector<std::pair<size_t, FaultSite>> sample;
+    std::mt19937_64 rng(seed);
+    size_t seen = 0;
+    for (size_t c = 0; c < classes.size(); ++c) {
+        for (size_t m = 1; m < classes[c].members.size(); ++m) {
+            ++seen;
+            if (sample.size() < count)
+                sample.emplace_back(c, classes[c].members[m]);
+            else {
+                size_t j = std::uniform_int_distribution<size_t>(0, seen - 1)(rng);
+                if (j < count)
+                    sample[j] = {c, classes[c].members[m]};
+            }
+        }
+    }
+    return sample;
+}
+
+size_t prunedSpaceSize(const std::vector<FaultClass>& classes) {
+    size_t total = 0;
+    for (const auto& c : classes)
+        total += c.members.size();
+    return total;
+}
+
+size_t pruneInjections(const std::vector<FaultClass>& classes) {
+    size_t total = 0;
+    for (const auto& c : classes)
+        total += c.rule == PruneRule::IDENTITY ? 0 : 1;
+    return total;
+}
@@ -0,0 +1,61 @@
+#ifndef FAULT_PRUNING_MATI_H
+#define FAULT_PRUNING_MATI_H
+
+#include "openfhe.h"
+#include "fault_model.h"
+
+#include <vector>
+#include <cstdint>
+using namespace lbcrypto;
+
+// Poda estatica del espacio (elemento, limb, coeff, bit) antes de una campaña.
+// Se inyecta un representante por clase y el resultado se copia al resto.
+//
+// Un flip de 1 bit en c0 suma d = +-2^b en un limb, y Decrypt es lineal en c0:
+// el error de salida es el de d solo. Con slots completos (gap = 0) la norma
+// sobre los slots es invariante ante automorfismos X -> X^k y ante el signo, asi:
+//   MONOMIAL   c0 en coeficientes: d = +-2^b X^i, la norma depende solo de
+//              (limb, bit) y de si i es 0, N/2 u otro (ver batch_eval.h)
+//   NTT_ORBIT  c0 en evaluacion: INTT(e_p) son todos imagenes por automorfismo
+//              entre si, la clase es (limb, bit) para todo p
+//   IDENTITY   stuck-at sobre un bit que ya tiene ese valor: igual al golden
+// Si el flip deja la palabra >= q_l (bits >= ceil(log2 q_l)) el efecto depende
+// de como se reduce el residuo no canonico en ese coeficiente: esos no se
+// podan, cada uno es su propia clase (PruneRule::NONE, canonical = false).
+//
+// Es exacto mientras golden + error no de la vuelta mod Q; pruneVerify inyecta
+// una muestra de faults podados para chequearlo. c1 (el error es d*s) y los
+// modelos multi-bit no se podan, cada fault es su propia clase.
+enum class PruneRule { NONE, IDENTITY, MONOMIAL, NTT_ORBIT };
+
+const char* pruneRuleName(PruneRule rule);
+
+struct FaultSite {
+    uint32_t element;
+    uint32_t limb;
+    uint32_t coeff;
+    uint32_t bit;
+};
+
+// members[0] es el representante
+struct FaultClass {
+    PruneRule rule;
+    bool canonical;
+    std::vector<FaultSite> members;
+};
+
+// elements[e] en el formato en el que se aplica el fault; su indice es el del
+// cifrado (0 = c0). Se barren todos los limbs, coeff de a coeffStep y los bits
+// de inicio de faultmodel::bitStride.
+std::vector<FaultClass> pruneFaultSpace(const std::vector<DCRTPoly>& elements, const faultmodel::Model& model,
+                                        uint32_t gap, uint32_t coeffStep);
+
+// Hasta count faults podados (no representantes) elegidos con seed, con el
+// indice de su clase
+std::vector<std::pair<size_t, FaultSite>> pruneVerifySample(const std::vector<FaultClass>& classes,
+                                                            size_t count, uint32_t seed);
+
+// Cantidad de faults cubiertos y de inyecciones necesarias
+size_t prunedSpaceSize(const std::vector<FaultClass>& classes);
+size_t pruneInjections(const std::vector<FaultClass>& classes);
+#endif
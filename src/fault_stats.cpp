@@ -0,0 +1,215 @@
+#include "fault_stats.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char kMagic[8] = {'F', 'S', 'T', 'A', 'T', 'S', '0', '2'};
+
+template <typename T>
+static void put(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool get(std::istream& in, T& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+int LogHistogram::bucket(double v) {
+    int e;
+    double m = std::frexp(v, &e);   // v = m * 2^e, m en [0.5, 1)
+    if (e - 1 < kMinExp)
+        return 0;
+    if (e - 1 > kMaxExp)
+        return kBuckets - 1;
+    int sub = std::min(static_cast<int>((2 * m - 1) * kSub), kSub - 1);
+    return (e - 1 - kMinExp) * kSub + sub;
+}
+
+double LogHistogram::upperBound(int bucket) {
+    int e = bucket / kSub + kMinExp;
+    int sub = bucket % kSub;
+    return std::ldexp(1.0 + static_cast<double>(sub + 1) / kSub, e);
+}
+
+void LogHistogram::add(double v) {
+    ++m_count;
+    if (!std::isfinite(v)) {
+        ++m_nonFinite;
+        return;
+    }
+    v = std::fabs(v);
+    m_max = std::max(m_max, v);
+    if (v == 0) {
+        ++m_zero;
+        return;
+    }
+    ++m_buckets[bucket(v)];
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+    m_count += other.m_count;
+    m_zero += other.m_zero;
+    m_nonFinite += other.m_nonFinite;
+    m_max = std::max(m_max, other.m_max);
+    for (int b = 0; b < kBuckets; ++b)
+        m_buckets[b] += other.m_buckets[b];
+}
+
+double LogHistogram::quantile(double q) const {
+    if (m_count == 0)
+        return 0;
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * m_count)));
+    uint64_t seen = m_zero;
+    if (seen >= rank)
+        return 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += m_buckets[b];
+        if (seen >= rank)
+            return std::min(upperBound(b), m_max);
+    }
+    return INFINITY;
+}
+
+bool LogHistogram::write(std::ostream& out) const {
+    put(out, m_count);
+    put(out, m_zero);
+    put(out, m_nonFinite);
+    put(out, m_max);
+    out.write(reinterpret_cast<const char*>(m_buckets), sizeof(m_buckets));
+    return static_cast<bool>(out);
+}
+
+bool LogHistogram::read(std::istream& in) {
+    return get(in, m_count) && get(in, m_zero) && get(in, m_nonFinite) && get(in, m_max) &&
+           in.read(reinterpret_cast<char*>(m_buckets), sizeof(m_buckets));
+}
+
+FaultStats::FaultStats(uint32_t elements, uint32_t limbs, uint32_t ringDim, uint32_t coeffCells)
+    : m_elements(elements), m_limbs(limbs), m_ringDim(ringDim),
+      m_coeffCells(coeffCells == 0 || coeffCells > ringDim ? ringDim : coeffCells),
+      m_bits(static_cast<size_t>(elements) * limbs * 64),
+      m_coeffs(static_cast<size_t>(elements) * limbs * m_coeffCells) {}
+
+void FaultStats::add(uint32_t element, uint32_t limb, uint32_t coeff, uint32_t bit, double norm, Outcome outcome) {
+    if (element >= m_elements || limb >= m_limbs || coeff >= m_ringDim || bit >= 64)
+        return;
+    int o = static_cast<int>(outcome);
+    BitCell& cell = m_bits[bitIndex(element, limb, bit)];
+    ++cell.outcomes[o];
+    cell.norms.add(norm);
+    ++m_coeffs[coeffIndex(element, limb, coeff)].outcomes[o];
+}
+
+bool FaultStats::merge(const FaultStats& other) {
+    if (m_bits.empty() && m_coeffs.empty()) {
+        *this = other;
+        return true;
+    }
+    if (other.m_elements != m_elements || other.m_limbs != m_limbs || other.m_ringDim != m_ringDim ||
+        other.m_coeffCells != m_coeffCells)
+        return false;
+    for (size_t i = 0; i < m_bits.size(); ++i) {
+        for (int o = 0; o < kOutcomes; ++o)
+            m_bits[i].outcomes[o] += other.m_bits[i].outcomes[o];
+        m_bits[i].norms.merge(other.m_bits[i].norms);
+    }
+    for (size_t i = 0; i < m_coeffs.size(); ++i)
+        for (int o = 0; o < kOutcomes; ++o)
+            m_coeffs[i].outcomes[o] += other.m_coeffs[i].outcomes[o];
+    return true;
+}
+
+uint64_t FaultStats::faults() const {
+    uint64_t n = 0;
+    for (const BitCell& cell : m_bits)
+        n += cell.norms.count();
+    return n;
+}
+
+bool FaultStats::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(kMagic, sizeof(kMagic));
+    put(out, m_elements);
+    put(out, m_limbs);
+    put(out, m_ringDim);
+    put(out, m_coeffCells);
+    int32_t shape[3] = {LogHistogram::kMinExp, LogHistogram::kMaxExp, LogHistogram::kSubBits};
+    out.write(reinterpret_cast<const char*>(shape), sizeof(shape));
+    for (const BitCell& cell : m_bits) {
+        out.write(reinterpret_cast<const char*>(cell.outcomes), sizeof(cell.outcomes));
+        cell.norms.write(out);
+    }
+    out.write(reinterpret_cast<const char*>(m_coeffs.data()), m_coeffs.size() * sizeof(CoeffCell));
+    return static_cast<bool>(out);
+}
+
+bool FaultStats::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    uint32_t elements, limbs, ringDim, coeffCells;
+    int32_t shape[3];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !get(in, elements) || !get(in, limbs) || !get(in, ringDim) || !get(in, coeffCells) ||
+        !in.read(reinterpret_cast<char*>(shape), sizeof(shape)))
+        return false;
+    // Los buckets tienen que ser los mismos para poder sumarlos
+    if (shape[0] != LogHistogram::kMinExp || shape[1] != LogHistogram::kMaxExp || shape[2] != LogHistogram::kSubBits)
+        return false;
+    if (ringDim == 0 || coeffCells == 0 || coeffCells > ringDim)
+        return false;
+    FaultStats stats(elements, limbs, ringDim, coeffCells);
+    for (BitCell& cell : stats.m_bits) {
+        if (!in.read(reinterpret_cast<char*>(cell.outcomes), sizeof(cell.outcomes)) || !cell.norms.read(in))
+            return false;
+    }
+    if (!in.read(reinterpret_cast<char*>(stats.m_coeffs.data()), stats.m_coeffs.size() * sizeof(CoeffCell)))
+        return false;
+    *this = std::move(stats);
+    return true;
+}
+
+std::string FaultStats::bitRows() const {
+    std::string rows;
+    for (uint32_t e = 0; e < m_elements; ++e) {
+        for (uint32_t l = 0; l < m_limbs; ++l) {
+            for (uint32_t bit = 0; bit < 64; ++bit) {
+                const BitCell& cell = m_bits[bitIndex(e, l, bit)];
+                if (cell.norms.count() == 0)
+                    continue;
+                rows.append(std::to_string(e) + "," + std::to_string(l) + "," + std::to_string(bit) + "," +
+                            std::to_string(cell.norms.count()));
+                for (int o = 0; o < kOutcomes; ++o)
+                    rows.append("," + std::to_string(cell.outcomes[o]));
+                rows.append("," + std::to_string(cell.norms.quantile(0.5)) + "," +
+                            std::to_string(cell.norms.quantile(0.9)) + "," +
+                            std::to_string(cell.norms.quantile(0.99)) + "," + std::to_string(cell.norms.max()) + "\n");
+            }
+        }
+    }
+    return rows;
+}
+
+std::string FaultStats::coeffRows() const {
+    std::string rows;
+    for (uint32_t e = 0; e < m_elements; ++e) {
+        for (uint32_t l = 0; l < m_limbs; ++l) {
+            for (uint32_t c = 0; c < m_coeffCells; ++c) {
+                const CoeffCell& cell = m_coeffs[(static_cast<size_t>(e) * m_limbs + l) * m_coeffCells + c];
+                uint64_t total = 0;
+                for (int o = 0; o < kOutcomes; ++o)
+                    total += cell.outcomes[o];
+                if (total == 0)
+                    continue;
+                rows.append(std::to_string(e) + "," + std::to_string(l) + "," + std::to_string(cellStart(c)) + "," +
+                            std::to_string(cellStart(c + 1)) + "," + std::to_string(total));
+                for (int o = 0; o < kOutcomes; ++o)
+                    rows.append("," + std::to_string(cell.outcomes[o]));
+                rows.append("\n");
+            }
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,108 @@
+#ifndef FAULT_STATS_MATI_H
+#define FAULT_STATS_MATI_H
+
+#include "utils.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Agregacion en linea de una campaña: en vez de guardar cada norma como texto
+// se acumulan histogramas y contadores de outcomes. La memoria depende de la
+// forma (elementos x limbs), no de N ni de la cantidad de faults.
+//
+// LogHistogram es estilo HDR: por cada exponente binario 2^kSubBits
+// sub-buckets lineales, error relativo <= 2^-kSubBits (~3%). Son 32 KB por
+// histograma, 4 MB por limb con los 64 bits de c0 y c1. Fuera de
+// [2^kMinExp, 2^(kMaxExp+1)) se satura al primer/ultimo bucket; cero y
+// no-finitos van aparte. Dos histogramas se mezclan sumando buckets, asi que
+// los shards de una campaña (otros procesos, otras semillas) se combinan
+// exacto con merge() o con stats_merge sobre los .bin.
+
+class LogHistogram {
+public:
+    static constexpr int kMinExp = -64;
+    static constexpr int kMaxExp = 63;
+    static constexpr int kSubBits = 5;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kBuckets = (kMaxExp - kMinExp + 1) * kSub;
+
+    void add(double v);
+    void merge(const LogHistogram& other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t nonFinite() const { return m_nonFinite; }
+    double max() const { return m_nonFinite ? INFINITY : m_max; }
+    // Limite superior del bucket del cuantil q (INFINITY si cae en los no-finitos)
+    double quantile(double q) const;
+
+    bool write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+private:
+    static int bucket(double v);
+    static double upperBound(int bucket);
+
+    uint64_t m_count = 0;
+    uint64_t m_zero = 0;
+    uint64_t m_nonFinite = 0;
+    double m_max = 0;
+    uint64_t m_buckets[kBuckets] = {};
+};
+
+// Histograma de normas y outcomes por (elemento, limb, bit) y outcomes por
+// (elemento, limb, rango de coeficientes). Los coeficientes se agrupan en
+// coeffCells rangos contiguos de N/coeffCells, asi la tabla no crece con N;
+// coeffCells = 0 (o >= N) deja una celda por coeficiente.
+class FaultStats {
+public:
+    static constexpr int kOutcomes = 5;   // Outcome::MASKED .. Outcome::CRASH
+    static constexpr uint32_t kCoeffCells = 256;
+
+    FaultStats() = default;
+    FaultStats(uint32_t elements, uint32_t limbs, uint32_t ringDim, uint32_t coeffCells = kCoeffCells);
+
+    void add(uint32_t element, uint32_t limb, uint32_t coeff, uint32_t bit, double norm, Outcome outcome);
+    // false si la forma no coincide
+    bool merge(const FaultStats& other);
+
+    uint64_t faults() const;
+
+    // Binario para mezclar entre procesos
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // elemento,limb,bit,faults,masked,sdc,parse,decrypt,crash,p50,p90,p99,max
+    std::string bitRows() const;
+    // elemento,limb,coeff_lo,coeff_hi,faults,masked,sdc,parse,decrypt,crash (coeff en [lo, hi))
+    std::string coeffRows() const;
+
+private:
+    struct BitCell {
+        uint64_t outcomes[kOutcomes] = {};
+        LogHistogram norms;
+    };
+    struct CoeffCell {
+        uint64_t outcomes[kOutcomes] = {};
+    };
+
+    size_t bitIndex(uint32_t element, uint32_t limb, uint32_t bit) const {
+        return (static_cast<size_t>(element) * m_limbs + limb) * 64 + bit;
+    }
+    size_t coeffIndex(uint32_t element, uint32_t limb, uint32_t coeff) const {
+        uint32_t cell = static_cast<uint32_t>(static_cast<uint64_t>(coeff) * m_coeffCells / m_ringDim);
+        return (static_cast<size_t>(element) * m_limbs + limb) * m_coeffCells + cell;
+    }
+    // Primer coeficiente de la celda
+    uint32_t cellStart(uint32_t cell) const {
+        return static_cast<uint32_t>((static_cast<uint64_t>(cell) * m_ringDim + m_coeffCells - 1) / m_coeffCells);
+    }
+
+    uint32_t m_elements = 0;
+    uint32_t m_limbs = 0;
+    uint32_t m_ringDim = 0;
+    uint32_t m_coeffCells = 0;
+    std::vector<BitCell> m_bits;
+    std::vector<CoeffCell> m_coeffs;
+};
+#endif
@@ -0,0 +1,176 @@
+#include "fault_targets.h"
+
+#include <map>
+#include <set>
+#include <sstream>
+
+using FTTNat     = intnat::ChineseRemainderTransformFTTNat<NativeVector>;
+using NTTTable   = std::map<NativeInteger, NativeVector>;
+
+const std::vector<std::string> NTT_TABLE_KINDS = {
+    "rootOfUnityReverse",
+    "rootOfUnityInverseReverse",
+    "rootOfUnityPreconReverse",
+    "rootOfUnityInversePreconReverse",
+    "cycloOrderInverse",
+    "cycloOrderInversePrecon",
+    "modulus",
+    "rootOfUnity",
+};
+
+const std::vector<std::string> KEY_KINDS = {
+    "secretKey",
+    "publicKey",
+    "relinKey",
+    "rotationKey",
+};
+
+bool selectedKind(const std::string& kinds, const std::string& kind) {
+    if (kinds == "all")
+        return true;
+    std::istringstream iss(kinds);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (item == kind)
+            return true;
+    }
+    return false;
+}
+
+static std::vector<std::pair<std::string, NTTTable*>> nttTables() {
+    return {
+        {"rootOfUnityReverse",              &FTTNat::m_rootOfUnityReverseTableByModulus},
+        {"rootOfUnityInverseReverse",       &FTTNat::m_rootOfUnityInverseReverseTableByModulus},
+        {"rootOfUnityPreconReverse",        &FTTNat::m_rootOfUnityPreconReverseTableByModulus},
+        {"rootOfUnityInversePreconReverse", &FTTNat::m_rootOfUnityInversePreconReverseTableByModulus},
+        {"cycloOrderInverse",               &FTTNat::m_cycloOrderInverseTableByModulus},
+        {"cycloOrderInversePrecon",         &FTTNat::m_cycloOrderInversePreconTableByModulus},
+    };
+}
+
+// NativeIntegerT<uint64_t> tiene un solo miembro, el valor, igual que en bitflip_check
+static uint64_t* wordsOf(const NativeInteger& v) {
+    return reinterpret_cast<uint64_t*>(const_cast<NativeInteger*>(&v));
+}
+
+std::vector<FaultTarget> collectNTTTables(const CryptoContext<DCRTPoly>& cc, const std::string& kinds) {
+    std::vector<FaultTarget> targets;
+    const auto& limbParams = cc->GetCryptoParameters()->GetElementParams()->GetParams();
+
+    for (const auto& table : nttTables()) {
+        if (!selectedKind(kinds, table.first))
+            continue;
+        for (uint32_t limb = 0; limb < limbParams.size(); ++limb) {
+            auto it = table.second->find(limbParams[limb]->GetModulus());
+            if (it == table.second->end() || it->second.GetLength() == 0) {
+                std::cerr << "[WARN] Tabla " << table.first << " no precomputada para limb " << limb << "\n";
+                continue;
+            }
+            targets.push_back({table.first, limb, wordsOf(it->second[0]), it->second.GetLength()});
+        }
+    }
+
+    for (uint32_t limb = 0; limb < limbParams.size(); ++limb) {
+        if (selectedKind(kinds, "modulus"))
+            targets.push_back({"modulus", limb, wordsOf(limbParams[limb]->GetModulus()), 1});
+        if (selectedKind(kinds, "rootOfUnity"))
+            targets.push_back({"rootOfUnity", limb, wordsOf(limbParams[limb]->GetRootOfUnity()), 1});
+    }
+    return targets;
+}
+
+// Un target por limb: cada limb es un NativeVector contiguo de ringDim palabras
+static void appendPoly(std::vector<FaultTarget>& targets, const std::string& kind, const DCRTPoly& poly) {
+    const auto& limbs = poly.GetAllElements();
+    for (uint32_t limb = 0; limb < limbs.size(); ++limb) {
+        const auto& values = limbs[limb].GetValues();
+        targets.push_back({kind, limb, wordsOf(values[0]), values.GetLength()});
+    }
+}
+
+static void appendEvalKey(std::vector<FaultTarget>& targets, const std::string& kind, const EvalKey<DCRTPoly>& key) {
+    const auto& a = key->GetAVector();
+    const auto& b = key->GetBVector();
+    for (size_t i = 0; i < a.size(); ++i)
+        appendPoly(targets, kind + ".a[" + std::to_string(i) + "]", a[i]);
+    for (size_t i = 0; i < b.size(); ++i)
+        appendPoly(targets, kind + ".b[" + std::to_string(i) + "]", b[i]);
+}
+
+std::vector<FaultTarget> collectKeyTargets(const CryptoContext<DCRTPoly>& cc, const KeyPair<DCRTPoly>& keys,
+                                           const std::string& kinds) {
+    std::vector<FaultTarget> targets;
+    const std::string tag = keys.secretKey->GetKeyTag();
+
+    if (selectedKind(kinds, "secretKey"))
+        appendPoly(targets, "secretKey", keys.secretKey->GetPrivateElement());
+
+    if (selectedKind(kinds, "publicKey")) {
+        const auto& pk = keys.publicKey->GetPublicElements();
+        for (size_t i = 0; i < pk.size(); ++i)
+            appendPoly(targets, "publicKey[" + std::to_string(i) + "]", pk[i]);
+    }
+
+    if (selectedKind(kinds, "relinKey")) {
+        const auto& relin = cc->GetEvalMultKeyVector(tag);
+        for (size_t i = 0; i < relin.size(); ++i)
+            appendEvalKey(targets, "relinKey" + (relin.size() > 1 ? "[" + std::to_string(i) + "]" : std::string()), relin[i]);
+    }
+
+    if (selectedKind(kinds, "rotationKey")) {
+        for (const auto& entry : cc->GetEvalAutomorphismKeyMap(tag))
+            appendEvalKey(targets, "rotationKey[" + std::to_string(entry.first) + "]", entry.second);
+    }
+    return targets;
+}
+
+void pruneForeignNTTTables(const CryptoContext<DCRTPoly>& cc) {
+    std::set<NativeInteger> moduli;
+    for (const auto& p : cc->GetCryptoParameters()->GetElementParams()->GetParams())
+        moduli.insert(p->GetModulus());
+
+    for (const auto& table : nttTables()) {
+        for (auto it = table.second->begin(); it != table.second->end();) {
+            if (moduli.count(it->first))
+                ++it;
+            else
+                it = table.second->erase(it);
+        }
+    }
+}
+
+TargetSnapshot::TargetSnapshot(const std::vector<FaultTarget>& targets) : m_targets(targets) {
+    m_pristine.reserve(targets.size());
+    for (const auto& t : targets)
+        m_pristine.emplace_back(t.words, t.words + t.numWords);
+}
+
+void TargetSnapshot::flip(size_t target, size_t word, uint64_t mask) {
+    m_targets[target].words[word] ^= mask;
+}
+
+void TargetSnapshot::restoreWord(size_t target, size_t word) {
+    m_targets[target].words[word] = m_pristine[target][word];
+}
+
+void TargetSnapshot::apply(size_t target, const faultmodel::DenseMask& dense) {
+    faultmodel::applyXor(m_targets[target].words, dense);
+}
+
+void TargetSnapshot::restore(size_t target, const faultmodel::DenseMask& dense) {
+    std::copy_n(m_pristine[target].begin() + dense.first, dense.masks.size(),
+                m_targets[target].words + dense.first);
+}
+
+void TargetSnapshot::restoreAll() {
+    for (size_t t = 0; t < m_targets.size(); ++t)
+        std::copy(m_pristine[t].begin(), m_pristine[t].end(), m_targets[t].words);
+}
+
+bool TargetSnapshot::isClean() const {
+    for (size_t t = 0; t < m_targets.size(); ++t) {
+        if (!std::equal(m_pristine[t].begin(), m_pristine[t].end(), m_targets[t].words))
+            return false;
+    }
+    return true;
+}
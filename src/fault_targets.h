@@ -0,0 +1,66 @@
+#ifndef FAULT_TARGETS_MATI_H
+#define FAULT_TARGETS_MATI_H
+
+#include "openfhe.h"
+#include "fault_model.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+using namespace lbcrypto;
+
+// Arreglo contiguo de palabras de 64 bits que una campaña puede corromper en el lugar.
+struct FaultTarget {
+    std::string kind;     // nombre de la tabla/clave, ej. "rootOfUnityReverse"
+    uint32_t limb;        // indice del limb RNS
+    uint64_t* words;
+    size_t numWords;
+};
+
+// Tablas persistentes que leen SwitchFormat/Decrypt: raices de la NTT, sus
+// constantes de Shoup (precon), inversas de N y los parametros de cada limb.
+extern const std::vector<std::string> NTT_TABLE_KINDS;
+
+// kinds: "all" o lista separada por comas de NTT_TABLE_KINDS.
+// Las tablas se calculan lazy, llamar despues de KeyGen.
+std::vector<FaultTarget> collectNTTTables(const CryptoContext<DCRTPoly>& cc, const std::string& kinds = "all");
+
+// Claves: secretKey, publicKey, relinKey (EvalMultKeyGen) y rotationKey (EvalRotateKeyGen).
+extern const std::vector<std::string> KEY_KINDS;
+
+// Un target por limb de cada DCRTPoly de las claves. kind lleva el componente,
+// ej. "relinKey.a[1]" o "rotationKey[5].b[0]" (5 es el indice de automorfismo).
+// Llamar despues de EvalMultKeyGen/EvalRotateKeyGen.
+std::vector<FaultTarget> collectKeyTargets(const CryptoContext<DCRTPoly>& cc, const KeyPair<DCRTPoly>& keys,
+                                           const std::string& kinds = "all");
+
+// Un fault en el modulo hace que OpenFHE precompute tablas para el modulo corrupto.
+// Esto las borra para que la memoria no crezca durante la campaña.
+void pruneForeignNTTTables(const CryptoContext<DCRTPoly>& cc);
+
+// Copia pristina de los targets. Restaurar es copiar solo las palabras tocadas,
+// no hace falta regenerar el contexto.
+class TargetSnapshot {
+public:
+    explicit TargetSnapshot(const std::vector<FaultTarget>& targets);
+
+    void flip(size_t target, size_t word, uint64_t mask);
+    void restoreWord(size_t target, size_t word);
+
+    // Fault multi-palabra de fault_model.h; las mascaras se generan contra pristine(target)
+    void apply(size_t target, const faultmodel::DenseMask& dense);
+    void restore(size_t target, const faultmodel::DenseMask& dense);
+    const uint64_t* pristine(size_t target) const { return m_pristine[target].data(); }
+
+    void restoreAll();
+    bool isClean() const;
+
+    const std::vector<FaultTarget>& targets() const { return m_targets; }
+
+private:
+    std::vector<FaultTarget> m_targets;
+    std::vector<std::vector<uint64_t>> m_pristine;
+};
+
+bool selectedKind(const std::string& kinds, const std::string& kind);
+#endif
@@ -0,0 +1,150 @@
+#ifndef METRICS_MATI_H
+#define METRICS_MATI_H
+
+// Metricas de error entre el resultado golden y el de un fault, en una sola
+// pasada. El conjunto de metricas se elige en compilacion con flags, lo que no
+// se pide no se calcula:
+//
+//   METRIC_RMS        sqrt(mean(e_i^2)), lo que devolvia norm2
+//   METRIC_LINF       max |e_i|
+//   METRIC_REL        mean(|e_i| / |golden_i|), slots con golden 0 no cuentan
+//   METRIC_BITS       bits de precision perdidos: log2(linf / noiseFloor)
+//   METRIC_SLOT_BITS  lo mismo por slot, en slotBits[i]
+//
+// noiseFloor es el error propio de CKKS (golden contra el plaintext); un fault
+// que queda por debajo no pierde bits. Es header-only para que el compilador
+// elimine las ramas de los flags apagados.
+//
+// En x86-64 el loop va de a dos slots con SSE2 (siempre disponible, no depende
+// de -march): sin -ffast-math GCC no vectoriza las reducciones de suma y max.
+// linf y bitsLost salen identicos al loop escalar; rms y meanRel solo cambian
+// el orden de la suma (dos acumuladores).
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+enum MetricFlags : unsigned {
+    METRIC_RMS       = 1u << 0,
+    METRIC_LINF      = 1u << 1,
+    METRIC_REL       = 1u << 2,
+    METRIC_BITS      = 1u << 3,
+    METRIC_SLOT_BITS = 1u << 4,
+    METRIC_ALL       = (1u << 5) - 1
+};
+
+struct ErrorMetrics {
+    double rms      = 0;
+    double linf     = 0;
+    double meanRel  = 0;
+    double bitsLost = 0;
+};
+
+inline double bitsLost(double err, double noiseFloor) {
+    if (std::isnan(err) || std::isinf(err))
+        return INFINITY;
+    if (err <= noiseFloor)
+        return 0;
+    // Sin piso (golden exacto) cualquier error es perdida total
+    if (noiseFloor <= 0)
+        return INFINITY;
+    return std::log2(err / noiseFloor);
+}
+
+template <unsigned Flags>
+ErrorMetrics errorMetrics(const double* golden, const double* faulty, size_t size,
+                          double noiseFloor = 0, double* slotBits = nullptr) {
+    constexpr bool wantSq   = Flags & METRIC_RMS;
+    constexpr bool wantMax  = Flags & (METRIC_LINF | METRIC_BITS);
+    constexpr bool wantRel  = Flags & METRIC_REL;
+    constexpr bool wantSlot = Flags & METRIC_SLOT_BITS;
+
+    double sq = 0, mx = 0, rel = 0;
+    size_t relCount = 0;
+    bool nonFinite = false;
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128d vSq = zero, vMx = zero, vRel = zero, vCnt = zero, vNan = zero;
+    for (; i + 2 <= size; i += 2) {
+        __m128d g = _mm_loadu_pd(golden + i);
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(faulty + i), g);
+        __m128d a = _mm_andnot_pd(signMask, d);
+        if constexpr (wantSq)
+            vSq = _mm_add_pd(vSq, _mm_mul_pd(d, d));
+        if constexpr (wantMax) {
+            // max ignora NaN (como std::max con mx primero), se acumulan aparte
+            vMx = _mm_max_pd(a, vMx);
+            vNan = _mm_or_pd(vNan, _mm_cmpunord_pd(a, a));
+        }
+        if constexpr (wantRel) {
+            __m128d ga = _mm_andnot_pd(signMask, g);
+            __m128d ok = _mm_cmpgt_pd(ga, zero);
+            // slots con golden 0 dividen por 1 y despues se descartan
+            __m128d den = _mm_or_pd(_mm_and_pd(ok, ga), _mm_andnot_pd(ok, one));
+            vRel = _mm_add_pd(vRel, _mm_and_pd(ok, _mm_div_pd(a, den)));
+            vCnt = _mm_add_pd(vCnt, _mm_and_pd(ok, one));
+        }
+        if constexpr (wantSlot) {
+            double lane[2];
+            _mm_storeu_pd(lane, a);
+            slotBits[i] = bitsLost(lane[0], noiseFloor);
+            slotBits[i + 1] = bitsLost(lane[1], noiseFloor);
+        }
+    }
+    double lanes[2];
+    if constexpr (wantSq) {
+        _mm_storeu_pd(lanes, vSq);
+        sq = lanes[0] + lanes[1];
+    }
+    if constexpr (wantMax) {
+        _mm_storeu_pd(lanes, vMx);
+        mx = std::max(lanes[0], lanes[1]);
+        nonFinite = _mm_movemask_pd(vNan) != 0;
+    }
+    if constexpr (wantRel) {
+        _mm_storeu_pd(lanes, vRel);
+        rel = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, vCnt);
+        relCount = static_cast<size_t>(lanes[0] + lanes[1]);
+    }
+#endif
+    for (; i < size; ++i) {
+        double d = faulty[i] - golden[i];
+        double a = std::fabs(d);
+        if constexpr (wantSq)
+            sq += d * d;
+        if constexpr (wantMax) {
+            mx = std::max(mx, a);
+            nonFinite |= std::isnan(a);
+        }
+        if constexpr (wantRel) {
+            double ga = std::fabs(golden[i]);
+            if (ga > 0) {
+                rel += a / ga;
+                ++relCount;
+            }
+        }
+        if constexpr (wantSlot)
+            slotBits[i] = bitsLost(a, noiseFloor);
+    }
+
+    ErrorMetrics m;
+    if (nonFinite)
+        mx = NAN;
+    if constexpr (wantSq)
+        m.rms = size ? std::sqrt(sq / size) : 0;
+    if constexpr (wantMax)
+        m.linf = mx;
+    if constexpr (wantRel)
+        m.meanRel = relCount ? rel / relCount : 0;
+    if constexpr ((Flags & METRIC_BITS) != 0)
+        m.bitsLost = bitsLost(mx, noiseFloor);
+    return m;
+}
+#endif
@@ -0,0 +1,224 @@
+#include "openfhe.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstdio>
+
+#ifndef OPENFHE_VERSION_STR
+#define OPENFHE_VERSION_STR "unknown"
+#endif
+
+namespace fs = std::filesystem;
+
+extern "C" void sync_marker();
+asm(
+    ".global sync_marker       \n"
+    ".type   sync_marker, @function \n"
+    "sync_marker:              \n"
+    "    nop                   \n"
+    "    ret                   \n"
+);
+
+extern "C" void addr_label();
+asm(
+    ".global addr_label       \n"
+    ".type   addr_label, @function \n"
+    "addr_label:              \n"
+    "    nop                 \n"
+    "    ret                 \n"
+);
+
+extern "C" void report_norm(const double* norm);
+asm(
+    ".global report_norm       \n"
+    ".type   report_norm, @function \n"
+    "report_norm:              \n"
+    "    nop                   \n"
+    "    ret                   \n"
+);
+
+extern "C" void start_measurement() __attribute__((used, noinline));
+extern "C" void end_measurement() __attribute__((used, noinline));
+
+extern "C" void start_measurement() {
+    asm volatile("nop");
+}
+
+extern "C" void end_measurement() {
+    asm volatile("nop");
+}
+
+// Rutinas con nombre fijo (sin mangling) para -func/-target_func de las pintools.
+// perf_gate_metrics queda en el ejecutable principal, la de memoria solo
+// instrumenta ese.
+extern "C" __attribute__((used, noinline)) void perf_gate_decrypt(const CryptoContext<DCRTPoly>& cc,
+                                                                  const PrivateKey<DCRTPoly>& secretKey,
+                                                                  const Ciphertext<DCRTPoly>& c, Plaintext* result) {
+    cc->Decrypt(secretKey, c, result);
+}
+
+extern "C" __attribute__((used, noinline)) ErrorMetrics perf_gate_metrics(const double* golden, const double* faulty,
+                                                                          size_t size, double noiseFloor) {
+    return errorMetrics<METRIC_LINF | METRIC_BITS>(golden, faulty, size, noiseFloor);
+}
+
+// Campaña fija y chica para los gates de regresion de performance: no lee
+// config.txt, asi el baseline no cambia cuando se tocan los parametros de las
+// campañas. logN=10, un limb, bits muestreados sobre c0 y c1.
+//
+// Uso: perf_gate [salida.json] [native|pin]; por defecto
+// logs/perf_gate/perf_gate.json y native.
+//   native  el flip de cada iteracion es un XOR en el proceso
+//   pin     no se toca el cifrado: inyecta la pintool. Cada iteracion sigue el
+//           protocolo de los drivers: addr_label una vez tras el golden,
+//           testVoid (flip), perf_gate_decrypt, perf_gate_metrics,
+//           report_norm y sync_marker (restore / siguiente fault). Junto a la
+//           salida se escriben target_address.txt (objeto DCRTPoly y base de
+//           c0, para NTT y checkpoint) y target_coeffs.txt (solo la base, para
+//           BitFlip).
+// El checksum es FNV-1a sobre "elemento,coeff,bit,outcome" de cada iteracion:
+// no depende del tiempo. En modo pin sin pintool todo es MASKED, y cada
+// pintool que inyecta tiene que dar un checksum propio y estable.
+static const uint32_t kLogN      = 10;
+static const uint32_t kFirstMod  = 60;
+static const uint32_t kScaleMod  = 50;
+static const uint32_t kCoeffStep = 16;
+static const uint32_t kBitStep   = 4;
+static const int      kLogMin    = -1;
+static const int      kLogMax    = 1;
+static const int      kSeed      = 1;
+static const double   kSdcBits   = 5;
+
+static uint64_t fnv1a(uint64_t h, const std::string& s) {
+    for (unsigned char ch : s) {
+        h ^= ch;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int main(int argc, char* argv[]) {
+    const char* home = getenv("HOME");
+    std::string path = std::string(home)+"/CKKS_PIN/";
+    std::string outFile = argc > 1 ? argv[1] : path + "/logs/perf_gate/perf_gate.json";
+    std::string mode = argc > 2 ? argv[2] : "native";
+    if (mode != "native" && mode != "pin") {
+        std::cerr << "[ERROR] Modo desconocido: " << mode << " (native o pin)\n";
+        return 1;
+    }
+    bool inProcess = mode == "native";
+    fs::path outPath(outFile);
+    if (outPath.has_parent_path() && !fs::exists(outPath.parent_path())) {
+        if (!fs::create_directories(outPath.parent_path())) {
+            std::cerr << "[ERROR] No se pudo crear el directorio\n";
+            return 1;
+        }
+    }
+
+    uint32_t ringDim = 1 << kLogN;
+    uint32_t batchSize = ringDim >> 1;
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(0);
+    parameters.SetScalingModSize(kScaleMod);
+    parameters.SetFirstModSize(kFirstMod);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(ringDim);
+    parameters.SetScalingTechnique(FIXEDMANUAL);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+    CryptoContext<DCRTPoly> cc = GenCryptoContext(parameters);
+    cc->Enable(PKE);
+    cc->Enable(LEVELEDSHE);
+    // Semilla antes de KeyGen: los faults en c1 se multiplican por s
+    lbcrypto::PseudoRandomNumberGenerator::SetPRNGSeed(kSeed);
+    auto keys = cc->KeyGen();
+
+    std::vector<double> input = uniform_dist(batchSize, kLogMin, kLogMax, kSeed, false);
+    Plaintext ptxt = cc->MakeCKKSPackedPlaintext(input);
+    auto c = cc->Encrypt(keys.publicKey, ptxt);
+    Plaintext golden_result;
+    cc->Decrypt(keys.secretKey, c, &golden_result);
+    golden_result->SetLength(batchSize);
+    std::vector<double> golden_result_vec = golden_result->GetRealPackedValue();
+    double noiseFloor = errorMetrics<METRIC_LINF>(input.data(), golden_result_vec.data(), batchSize).linf;
+
+    // Ida y vuelta para que el SwitchFormat de -format_func ya este resuelto
+    c->GetElements()[0].SwitchFormat();
+    c->GetElements()[0].SwitchFormat();
+    auto raw_ctxt = c.get();
+    auto& c_elem_ptr = raw_ctxt->GetElements()[0].GetAllElements()[0][0];
+    fs::path addrDir = outPath.has_parent_path() ? outPath.parent_path() : fs::path(".");
+    std::ofstream ofs(addrDir / "target_address.txt");
+    ofs << std::hex << reinterpret_cast<uintptr_t>(&(raw_ctxt->GetElements()[0]))<< "\n";
+    ofs << std::hex << reinterpret_cast<uintptr_t>(&c_elem_ptr)<< "\n";
+    ofs.close();
+    std::ofstream coeffs(addrDir / "target_coeffs.txt");
+    coeffs << std::hex << reinterpret_cast<uintptr_t>(&c_elem_ptr)<< "\n";
+    coeffs.close();
+    addr_label();
+
+    uint64_t checksum = 0xcbf29ce484222325ULL;
+    uint64_t flips = 0;
+    uint64_t counts[5] = {};
+    Plaintext result_bitFlip;
+    auto t0 = std::chrono::steady_clock::now();
+    start_measurement();
+    for (uint32_t e = 0; e < c->GetElements().size(); ++e) {
+        auto& limb = c->GetElements()[e].GetAllElements()[0];
+        uint64_t* words = reinterpret_cast<uint64_t*>(&limb[0]);
+        for (uint32_t coeff = 0; coeff < ringDim; coeff += kCoeffStep) {
+            for (uint32_t bit = 0; bit < 64; bit += kBitStep) {
+                if (inProcess)
+                    words[coeff] ^= 1ULL << bit;
+                // Bajo PIN: flip en la pintool
+                testVoid();
+                Outcome outcome = Outcome::DECRYPT_FAIL;
+                double norm = INFINITY;
+                try {
+                    perf_gate_decrypt(cc, keys.secretKey, c, &result_bitFlip);
+                    result_bitFlip->SetLength(batchSize);
+                    std::vector<double> result_bitFlip_vec = result_bitFlip->GetRealPackedValue();
+                    ErrorMetrics metrics = perf_gate_metrics(golden_result_vec.data(), result_bitFlip_vec.data(),
+                                                             batchSize, noiseFloor);
+                    outcome = classifyOutcome(metrics, kSdcBits);
+                    norm = metrics.linf;
+                }
+                catch (const std::exception& ex) {
+                    // Decode tira excepcion cuando el error de aproximacion es muy grande
+                }
+                if (inProcess)
+                    words[coeff] ^= 1ULL << bit;
+                report_norm(&norm);
+                // Bajo PIN: restore / siguiente fault
+                sync_marker();
+                ++counts[static_cast<int>(outcome)];
+                ++flips;
+                checksum = fnv1a(checksum, std::to_string(e) + "," + std::to_string(coeff) + "," +
+                                           std::to_string(bit) + "," + outcomeName(outcome) + "\n");
+            }
+        }
+    }
+    end_measurement();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  "{\"openfhe\": \"" OPENFHE_VERSION_STR "\", \"mode\": \"%s\", \"flips\": %llu, "
+                  "\"seconds\": %.6f, \"flips_per_sec\": %.3f, \"checksum\": \"%016llx\", "
+                  "\"masked\": %llu, \"sdc\": %llu, \"decrypt_fail\": %llu}\n",
+                  mode.c_str(), static_cast<unsigned long long>(flips), seconds, flips / seconds,
+                  static_cast<unsigned long long>(checksum),
+                  static_cast<unsigned long long>(counts[static_cast<int>(Outcome::MASKED)]),
+                  static_cast<unsigned long long>(counts[static_cast<int>(Outcome::SDC)]),
+                  static_cast<unsigned long long>(counts[static_cast<int>(Outcome::DECRYPT_FAIL)]));
+    std::cout << buf;
+
+    std::ofstream gateFile(outFile);
+    if (!gateFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero del gate\n";
+        return 1;
+    }
+    gateFile << buf;
+    gateFile.close();
+    std::cout<< "File of perf gate is save" << std::endl;
+    return 0;
+}
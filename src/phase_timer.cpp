@@ -0,0 +1,194 @@
+#include "phase_timer.h"
+
+#ifdef PHASE_TIMERS
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace phasetimer {
+
+std::atomic<bool> dumpRequested{false};
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> phases;
+    std::vector<std::string> counters;
+    std::vector<ThreadBuffer*> buffers;   // no se liberan: el dump de atexit los necesita
+    std::string path;
+    uint64_t tsc0 = 0;
+    std::chrono::steady_clock::time_point t0;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry();   // vive hasta despues de los atexit
+    return *r;
+}
+
+int intern(std::vector<std::string>& names, const char* name) {
+    for (size_t i = 0; i < names.size(); ++i)
+        if (names[i] == name)
+            return static_cast<int>(i);
+    if (names.size() == kMaxPhases) {
+        std::cerr << "[WARN] phase_timer: mas de " << kMaxPhases << " fases, " << name << " se suma a la ultima\n";
+        return kMaxPhases - 1;
+    }
+    names.emplace_back(name);
+    return static_cast<int>(names.size() - 1);
+}
+
+void onSigusr1(int) {
+    dumpRequested.store(true, std::memory_order_relaxed);
+}
+
+void dumpAtExit() {
+    dumpNow();
+}
+
+// ns por tick desde install(); con steady_clock es 1
+double nsPerTick(const Registry& r) {
+#if defined(__x86_64__)
+    uint64_t dtsc = ticks() - r.tsc0;
+    double dns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.t0).count();
+    return dtsc ? dns / dtsc : 0;
+#else
+    (void)r;
+    return 1;
+#endif
+}
+
+std::string number(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", v);
+    return buf;
+}
+
+// Percentil sobre el histograma: limite superior del bucket que lo contiene
+double bucketPercentile(const uint64_t* hist, uint64_t count, double p, double scale) {
+    uint64_t rank = static_cast<uint64_t>(p * count + 0.999999);
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += hist[b];
+        if (seen >= rank && hist[b])
+            return b ? std::ldexp(1.0, b) * scale : 0;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int phaseId(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return intern(r.phases, name);
+}
+
+int counterId(const char* name) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return intern(r.counters, name);
+}
+
+ThreadBuffer* newBuffer() {
+    Registry& r = registry();
+    ThreadBuffer* b = new ThreadBuffer();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.buffers.push_back(b);
+    return b;
+}
+
+void install(const std::string& path) {
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.path = path;
+        r.tsc0 = ticks();
+        r.t0 = std::chrono::steady_clock::now();
+    }
+    std::atexit(dumpAtExit);
+    struct sigaction sa{};
+    sa.sa_handler = onSigusr1;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, nullptr);
+}
+
+void dumpNow() {
+    dumpRequested.store(false, std::memory_order_relaxed);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (r.path.empty())
+        return;
+    double scale = nsPerTick(r);
+
+    std::string out = "{\n  \"clock\": \"";
+#if defined(__x86_64__)
+    out += "rdtsc";
+#else
+    out += "steady_clock";
+#endif
+    out += "\",\n  \"ns_per_tick\": " + std::to_string(scale) + ",\n  \"threads\": " +
+           std::to_string(r.buffers.size()) + ",\n  \"phases\": [\n";
+    for (size_t p = 0; p < r.phases.size(); ++p) {
+        uint64_t count = 0, sum = 0, mn = UINT64_MAX, mx = 0, hist[kBuckets] = {};
+        for (ThreadBuffer* b : r.buffers) {
+            const PhaseSlot& s = b->phases[p];
+            count += s.count.load(std::memory_order_relaxed);
+            sum += s.sum.load(std::memory_order_relaxed);
+            mn = std::min(mn, s.min.load(std::memory_order_relaxed));
+            mx = std::max(mx, s.max.load(std::memory_order_relaxed));
+            for (int k = 0; k < kBuckets; ++k)
+                hist[k] += s.hist[k].load(std::memory_order_relaxed);
+        }
+        out += "    {\"name\": \"" + r.phases[p] + "\", \"count\": " + std::to_string(count) +
+               ", \"total_ns\": " + number(sum * scale) +
+               ", \"mean_ns\": " + number(count ? sum * scale / count : 0) +
+               ", \"min_ns\": " + number(count ? mn * scale : 0) + ", \"max_ns\": " + number(mx * scale) +
+               ", \"p50_ns\": " + number(bucketPercentile(hist, count, 0.5, scale)) +
+               ", \"p90_ns\": " + number(bucketPercentile(hist, count, 0.9, scale)) +
+               ", \"p99_ns\": " + number(bucketPercentile(hist, count, 0.99, scale)) + ", \"hist\": [";
+        // [limite superior en ns, cantidad] de los buckets no vacios
+        bool first = true;
+        for (int k = 0; k < kBuckets; ++k) {
+            if (!hist[k])
+                continue;
+            out += (first ? "[" : ", [") + number(k ? std::ldexp(1.0, k) * scale : 0) + ", " +
+                   std::to_string(hist[k]) + "]";
+            first = false;
+        }
+        out += std::string("]}") + (p + 1 < r.phases.size() ? ",\n" : "\n");
+    }
+    out += "  ],\n  \"counters\": [\n";
+    for (size_t c = 0; c < r.counters.size(); ++c) {
+        uint64_t value = 0;
+        for (ThreadBuffer* b : r.buffers)
+            value += b->counters[c].load(std::memory_order_relaxed);
+        out += "    {\"name\": \"" + r.counters[c] + "\", \"value\": " + std::to_string(value) + "}" +
+               (c + 1 < r.counters.size() ? ",\n" : "\n");
+    }
+    out += "  ]\n}\n";
+
+    std::filesystem::path outPath(r.path);
+    std::error_code ec;
+    if (outPath.has_parent_path())
+        std::filesystem::create_directories(outPath.parent_path(), ec);
+    std::ofstream file(r.path);
+    if (!file) {
+        std::cerr << "[ERROR] No pude abrir el fichero de fases " << r.path << "\n";
+        return;
+    }
+    file << out;
+}
+
+}  // namespace phasetimer
+
+#endif
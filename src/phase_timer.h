@@ -0,0 +1,128 @@
+#ifndef PHASE_TIMER_MATI_H
+#define PHASE_TIMER_MATI_H
+
+// Timers y contadores por fase para el loop de las campañas.
+//
+//   phasetimer::install(dir_log + "log_phases/phases" + endFile);
+//   for (...) {
+//       { PHASE_SCOPE("decrypt"); cc->Decrypt(...); }
+//       PHASE_COUNT("faults", 1);
+//   }
+//
+// Cada hilo acumula en su propio buffer (histograma log2 de ticks, count, suma,
+// min y max por fase) sin locks. Al salir (atexit) y con SIGUSR1 se agregan los
+// buffers de todos los hilos y se escribe un JSON. El handler de SIGUSR1 solo
+// levanta un flag: el dump lo hace el siguiente PHASE_SCOPE que termine.
+//
+// Con rdtsc en x86_64 (steady_clock en otro caso); los ticks se pasan a ns con
+// la relacion tsc/steady_clock medida entre install() y el dump.
+//
+// Sin -DPHASE_TIMERS (cmake -DPHASE_TIMERS=ON) los macros no generan codigo.
+
+#ifdef PHASE_TIMERS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace phasetimer {
+
+constexpr int kMaxPhases = 64;
+constexpr int kBuckets = 65;   // bucket 0: 0 ticks; bucket b: ticks en [2^(b-1), 2^b)
+
+struct PhaseSlot {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> hist[kBuckets] = {};
+};
+
+// Solo escribe el hilo duenio; el dump lee con loads relaxed
+struct ThreadBuffer {
+    PhaseSlot phases[kMaxPhases];
+    std::atomic<uint64_t> counters[kMaxPhases] = {};
+};
+
+// Registra el nombre una vez por call site (static local) y devuelve su id
+int phaseId(const char* name);
+int counterId(const char* name);
+// Crea el buffer del hilo y lo agrega a la lista que recorre el dump
+ThreadBuffer* newBuffer();
+inline thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+inline ThreadBuffer& localBuffer() {
+    if (!tlsBuffer)
+        tlsBuffer = newBuffer();
+    return *tlsBuffer;
+}
+// Dump pedido por SIGUSR1
+extern std::atomic<bool> dumpRequested;
+void dumpNow();
+
+// Escribe el JSON en path al salir y con SIGUSR1
+void install(const std::string& path);
+
+inline uint64_t ticks() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline void bump(std::atomic<uint64_t>& a, uint64_t v) {
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+inline void record(int id, uint64_t dt) {
+    PhaseSlot& s = localBuffer().phases[id];
+    bump(s.count, 1);
+    bump(s.sum, dt);
+    if (dt < s.min.load(std::memory_order_relaxed)) s.min.store(dt, std::memory_order_relaxed);
+    if (dt > s.max.load(std::memory_order_relaxed)) s.max.store(dt, std::memory_order_relaxed);
+    bump(s.hist[dt ? 64 - __builtin_clzll(dt) : 0], 1);
+    if (dumpRequested.load(std::memory_order_relaxed))
+        dumpNow();
+}
+
+class Scope {
+public:
+    explicit Scope(int id) : m_id(id), m_t0(ticks()) {}
+    ~Scope() { record(m_id, ticks() - m_t0); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    int m_id;
+    uint64_t m_t0;
+};
+
+}  // namespace phasetimer
+
+#define PHASE_CAT2(a, b) a##b
+#define PHASE_CAT(a, b) PHASE_CAT2(a, b)
+// Mide desde aca hasta el final del bloque
+#define PHASE_SCOPE(name)                                                        \
+    static const int PHASE_CAT(phaseId_, __LINE__) = phasetimer::phaseId(name);  \
+    phasetimer::Scope PHASE_CAT(phaseScope_, __LINE__)(PHASE_CAT(phaseId_, __LINE__))
+#define PHASE_COUNT(name, n)                                                     \
+    do {                                                                         \
+        static const int phaseCounterId_ = phasetimer::counterId(name);          \
+        phasetimer::bump(phasetimer::localBuffer().counters[phaseCounterId_], (n)); \
+    } while (0)
+#define PHASE_INSTALL(path) phasetimer::install(path)
+
+#else
+
+#define PHASE_SCOPE(name) ((void)0)
+#define PHASE_COUNT(name, n) ((void)0)
+#define PHASE_INSTALL(path) ((void)0)
+
+#endif
+#endif
@@ -0,0 +1,142 @@
+#include "pipeline.h"
+
+#include <sstream>
+
+// Coeficientes de la etapa poly
+static const double POLY_C0 = 0.5;
+static const double POLY_C1 = 0.25;
+static const double POLY_C2 = 0.125;
+
+std::vector<Stage> parsePipeline(const std::string& spec) {
+    std::vector<Stage> stages;
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        std::string name = item.substr(0, item.find(':'));
+        int32_t param = 0;
+        if (item.find(':') != std::string::npos)
+            param = std::stoi(item.substr(item.find(':') + 1));
+
+        if (name == "mult")
+            stages.push_back({StageKind::MULT_RESCALE, 0});
+        else if (name == "add")
+            stages.push_back({StageKind::ADD_CHAIN, param > 0 ? param : 1});
+        else if (name == "rot")
+            stages.push_back({StageKind::ROTATE, param});
+        else if (name == "poly")
+            stages.push_back({StageKind::POLY, 2});
+        else
+            throw std::invalid_argument("Etapa de pipeline desconocida: " + item);
+    }
+    return stages;
+}
+
+std::string stageName(const Stage& stage) {
+    switch (stage.kind) {
+        case StageKind::MULT_RESCALE: return "mult";
+        case StageKind::ADD_CHAIN:    return "add:" + std::to_string(stage.param);
+        case StageKind::ROTATE:       return "rot:" + std::to_string(stage.param);
+        case StageKind::POLY:         return "poly";
+    }
+    return "unknown";
+}
+
+Pipeline::Pipeline(CryptoContext<DCRTPoly> cc, std::vector<Stage> stages)
+    : m_cc(cc), m_stages(std::move(stages)) {}
+
+uint32_t Pipeline::depth(const std::vector<Stage>& stages) {
+    uint32_t d = 0;
+    for (const auto& s : stages) {
+        if (s.kind == StageKind::MULT_RESCALE)
+            d += 1;
+        else if (s.kind == StageKind::POLY)
+            d += 2;   // x^2 y despues c2*x^2, cada uno con su Rescale
+    }
+    return d;
+}
+
+void Pipeline::genKeys(const PrivateKey<DCRTPoly>& secretKey) const {
+    std::vector<int32_t> rotations;
+    bool needsMult = false;
+    for (const auto& s : m_stages) {
+        if (s.kind == StageKind::ROTATE)
+            rotations.push_back(s.param);
+        if (s.kind == StageKind::MULT_RESCALE || s.kind == StageKind::POLY)
+            needsMult = true;
+    }
+    if (needsMult)
+        m_cc->EvalMultKeyGen(secretKey);
+    if (!rotations.empty())
+        m_cc->EvalRotateKeyGen(secretKey, rotations);
+}
+
+Ciphertext<DCRTPoly> Pipeline::runStage(size_t k, const Ciphertext<DCRTPoly>& in) const {
+    const Stage& s = m_stages[k];
+    switch (s.kind) {
+        case StageKind::MULT_RESCALE:
+            return m_cc->Rescale(m_cc->EvalMult(in, in));
+        case StageKind::ADD_CHAIN: {
+            auto acc = in;
+            for (int32_t i = 0; i < s.param; ++i)
+                acc = m_cc->EvalAdd(acc, in);
+            return acc;
+        }
+        case StageKind::ROTATE:
+            return m_cc->EvalRotate(in, s.param);
+        case StageKind::POLY: {
+            // sq consume dos niveles (x^2 y c2*x^2, un Rescale cada uno) y lin uno;
+            // lin baja un nivel mas para sumar con el mismo nivel y escala
+            auto x2  = m_cc->Rescale(m_cc->EvalMult(in, in));
+            auto sq  = m_cc->Rescale(m_cc->EvalMult(x2, POLY_C2));
+            auto lin = m_cc->Rescale(m_cc->EvalMult(in, POLY_C1));
+            lin = m_cc->LevelReduce(lin, nullptr, 1);
+            return m_cc->EvalAdd(m_cc->EvalAdd(sq, lin), POLY_C0);
+        }
+    }
+    return in;
+}
+
+std::vector<Ciphertext<DCRTPoly>> Pipeline::runGolden(const Ciphertext<DCRTPoly>& input) const {
+    std::vector<Ciphertext<DCRTPoly>> snapshots;
+    snapshots.reserve(m_stages.size() + 1);
+    snapshots.push_back(input);
+    for (size_t k = 0; k < m_stages.size(); ++k)
+        snapshots.push_back(runStage(k, snapshots.back()));
+    return snapshots;
+}
+
+Ciphertext<DCRTPoly> Pipeline::resumeFrom(size_t k, const Ciphertext<DCRTPoly>& snapshot) const {
+    auto ct = snapshot;
+    for (size_t i = k; i < m_stages.size(); ++i)
+        ct = runStage(i, ct);
+    return ct;
+}
+
+bool Pipeline::linearFrom(size_t k) const {
+    for (size_t i = k; i < m_stages.size(); ++i) {
+        if (m_stages[i].kind != StageKind::ADD_CHAIN && m_stages[i].kind != StageKind::ROTATE)
+            return false;
+    }
+    return true;
+}
+
+std::vector<double> Pipeline::evalPlain(std::vector<double> values) const {
+    for (const auto& s : m_stages) {
+        std::vector<double> next(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            double x = values[i];
+            switch (s.kind) {
+                case StageKind::MULT_RESCALE: next[i] = x * x; break;
+                case StageKind::ADD_CHAIN:    next[i] = (s.param + 1) * x; break;
+                case StageKind::ROTATE: {
+                    int64_t n = static_cast<int64_t>(values.size());
+                    next[i] = values[((static_cast<int64_t>(i) + s.param) % n + n) % n];
+                    break;
+                }
+                case StageKind::POLY:         next[i] = POLY_C2 * x * x + POLY_C1 * x + POLY_C0; break;
+            }
+        }
+        values = std::move(next);
+    }
+    return values;
+}
@@ -0,0 +1,58 @@
+#ifndef PIPELINE_MATI_H
+#define PIPELINE_MATI_H
+
+#include "openfhe.h"
+
+#include <vector>
+#include <string>
+using namespace lbcrypto;
+
+// Etapas de un pipeline homomorfico. Spec en config.txt, separadas por comas:
+//   mult        EvalMult(x, x) + Rescale                (1 nivel)
+//   add:n       n EvalAdd encadenados con la entrada    (x -> (n+1)x)
+//   rot:k       EvalRotate(x, k)
+//   poly        c2*x^2 + c1*x + c0 con Rescale          (2 niveles)
+// mult y poly elevan al cuadrado: el resultado tiene que entrar en firstMod-scaleMod bits.
+enum class StageKind { MULT_RESCALE, ADD_CHAIN, ROTATE, POLY };
+
+struct Stage {
+    StageKind kind;
+    int32_t param;
+};
+
+std::vector<Stage> parsePipeline(const std::string& spec);
+std::string stageName(const Stage& stage);
+
+class Pipeline {
+public:
+    Pipeline(CryptoContext<DCRTPoly> cc, std::vector<Stage> stages);
+
+    // Profundidad multiplicativa que necesita el pipeline
+    static uint32_t depth(const std::vector<Stage>& stages);
+
+    // Claves de relinealizacion y rotacion que usan las etapas
+    void genKeys(const PrivateKey<DCRTPoly>& secretKey) const;
+
+    // Corrida golden: snapshots[k] es la entrada de la etapa k, snapshots[size()] la salida.
+    std::vector<Ciphertext<DCRTPoly>> runGolden(const Ciphertext<DCRTPoly>& input) const;
+
+    // Recalcula solo las etapas k..size()-1 desde el snapshot de la etapa k
+    Ciphertext<DCRTPoly> resumeFrom(size_t k, const Ciphertext<DCRTPoly>& snapshot) const;
+
+    // Mismo pipeline en claro, para validar la corrida golden
+    std::vector<double> evalPlain(std::vector<double> values) const;
+
+    // Las etapas k..size()-1 son lineales en el cifrado (add y rot), un fault en
+    // c0 se propaga como un error aditivo independiente del golden
+    bool linearFrom(size_t k) const;
+
+    size_t size() const { return m_stages.size(); }
+    const Stage& stage(size_t k) const { return m_stages[k]; }
+
+private:
+    Ciphertext<DCRTPoly> runStage(size_t k, const Ciphertext<DCRTPoly>& in) const;
+
+    CryptoContext<DCRTPoly> m_cc;
+    std::vector<Stage> m_stages;
+};
+#endif
@@ -0,0 +1,40 @@
+#include "fault_stats.h"
+
+// Mezcla los .bin de log_stats/ (shards, semillas, procesos) en uno solo y
+// escribe los resumenes de texto al lado:
+//   stats_merge out.bin stats_1_1.bin stats_1_2.bin ...
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: stats_merge out.bin in1.bin [in2.bin ...]\n";
+        return 1;
+    }
+    std::string out = argv[1];
+    FaultStats merged;
+    for (int i = 2; i < argc; ++i) {
+        FaultStats shard;
+        if (!shard.load(argv[i])) {
+            std::cerr << "[ERROR] No pude leer " << argv[i] << "\n";
+            return 1;
+        }
+        if (!merged.merge(shard)) {
+            std::cerr << "[ERROR] " << argv[i] << " tiene otra forma (elementos, limbs, N, celdas de coeff)\n";
+            return 1;
+        }
+    }
+    if (!merged.save(out)) {
+        std::cerr << "[ERROR] No pude escribir " << out << "\n";
+        return 1;
+    }
+    std::string base = out.size() > 4 && out.compare(out.size() - 4, 4, ".bin") == 0 ? out.substr(0, out.size() - 4) : out;
+    std::ofstream bitsFile(base + "_bits.txt");
+    std::ofstream coeffFile(base + "_coeff.txt");
+    if (!bitsFile || !coeffFile) {
+        std::cerr << "[ERROR] No pude abrir el fichero de estadisticas\n";
+        return 1;
+    }
+    bitsFile << merged.bitRows();
+    coeffFile << merged.coeffRows();
+    std::cout << merged.faults() << " faults de " << argc - 2 << " archivos" << std::endl;
+    std::cout << "File of stats is save" << std::endl;
+    return 0;
+}
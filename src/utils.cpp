@@ -39,17 +39,33 @@ void save_vector(const std::vector<double>& vec, const std::string& filename) {
 
 void testVoid(){
 }
-double norm2(std::vector<double>  &vecInput, std::vector<double> &vecOutput, size_t size){
-    double res = 0;
-    double diff = 0;
+double norm2(const std::vector<double>& vecInput, const std::vector<double>& vecOutput, size_t size){
     // Itero sobre el del input por si el del output por construccion quedo mas grande
-    for (size_t i=0; i<size; i++)
-    {
-        diff = vecOutput[i] - vecInput[i];
-        res += pow(diff, 2);
+    return errorMetrics<METRIC_RMS>(vecInput.data(), vecOutput.data(), size).rms;
+}
+
+const char* outcomeName(Outcome outcome) {
+    switch (outcome) {
+        case Outcome::MASKED:       return "masked";
+        case Outcome::SDC:          return "sdc";
+        case Outcome::PARSE_FAIL:   return "parse";
+        case Outcome::DECRYPT_FAIL: return "decrypt";
+        case Outcome::CRASH:        return "crash";
     }
-    res = std::sqrt(res/size);
-    return res;
+    return "unknown";
+}
+
+Outcome classifyOutcome(const ErrorMetrics& metrics, double thresholdBits) {
+    return metrics.bitsLost <= thresholdBits ? Outcome::MASKED : Outcome::SDC;
+}
+
+std::vector<uint32_t> parseList(const std::string& list) {
+    std::vector<uint32_t> values;
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ','))
+        values.push_back(std::stoul(item));
+    return values;
 }
 
 std::unordered_map<std::string, std::string> loadConfig(const std::string& filename) {
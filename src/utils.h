@@ -2,6 +2,7 @@
 #define UTILS_MATI_H
 
 #include "openfhe.h"
+#include "metrics.h"
 
 #include <vector>
 #include <string>
@@ -27,8 +28,17 @@ void save_vector(const std::vector<double>& vec, const std::string& filename);
 
 void testVoid();
 std::unordered_map<std::string, std::string> loadConfig(const std::string& filename);
+// Lista separada por comas de config.txt, ej. "10,12,14"
+std::vector<uint32_t> parseList(const std::string& list);
 std::vector<double> uniform_dist(uint32_t batchSize, uint64_t  logMin, uint64_t logMax, int seed, bool verbose=false);
 
-double norm2(std::vector<double>  &vecInput, std::vector<double> &vecOutput, size_t size);
+// RMS de la diferencia; para mas metricas en la misma pasada usar errorMetrics
+double norm2(const std::vector<double>& vecInput, const std::vector<double>& vecOutput, size_t size);
+
+// Clasificacion del resultado de un fault
+enum class Outcome { MASKED, SDC, PARSE_FAIL, DECRYPT_FAIL, CRASH };
+const char* outcomeName(Outcome outcome);
+// MASKED si el fault pierde a lo sumo thresholdBits bits de precision (sdcThresholdBits), si no SDC
+Outcome classifyOutcome(const ErrorMetrics& metrics, double thresholdBits);
 #endif
 